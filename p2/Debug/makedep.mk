@@ -22,16 +22,20 @@ rtos\kernel\mailbox\mailbox.c
 
 rtos\kernel\mutex\mutex.c
 
+rtos\kernel\others\HandleTable.c
+
 rtos\kernel\others\kmalloc.c
 
-rtos\kernel\others\PtrList.c
+rtos\kernel\queue\isr_queue.c
+
 
-rtos\kernel\others\Queue.c
 
 rtos\kernel\semaphore\semaphore.c
 
 rtos\kernel\task\task.c
 
+rtos\kernel\task\workspace.c
+
 rtos\os.c
 
 rtos_test.c
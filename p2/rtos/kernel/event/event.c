@@ -1,26 +1,26 @@
 #include "event.h"
-#include <stdlib.h>		//Remove once kmalloc is used
 
-volatile static PtrList EventList;				//Contains all the event objects 
+#if MAXEVENT > HANDLE_MAX_SLOTS
+#error "MAXEVENT is larger than a handle table can hold"
+#endif
+
+static EVENT_TYPE Event_Pool[MAXEVENT];
+static HandleSlot Event_Slots[MAXEVENT];
+static HandleTable EventTable;					//Maps EVENT IDs to the event objects
 volatile unsigned int Event_Count;				//Number of events created so far.
-volatile unsigned int Last_EventID;				//Last (also highest) EVENT value created so far.
 
 
 void Event_Reset()
 {	
 	Event_Count = 0;
-	Last_EventID = 0;
-	
-	EventList.ptr = NULL;
-	EventList.next = NULL;
+	handle_table_init(&EventTable, Event_Slots, Event_Pool, sizeof(EVENT_TYPE), MAXEVENT);
 }
 
 
 
 EVENT_TYPE* findEventByEventID(EVENT e)
 {
-	PtrList *i;
-	EVENT_TYPE *event_i;
+	EVENT_TYPE *event;
 	
 	//Ensure the request event ID is > 0
 	if(e <= 0)
@@ -32,15 +32,11 @@ EVENT_TYPE* findEventByEventID(EVENT e)
 		return NULL;
 	}
 	
-	for(i = &EventList; i; i = i->next)
-	{
-		event_i = (EVENT_TYPE*)i->ptr;
-		if (event_i->id == e)
-			return event_i;
-	}
+	event = handle_lookup(&EventTable, e);
+	if(!event)
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
 	
-	kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-	return NULL;
+	return event;
 }
 
 
@@ -48,11 +44,10 @@ EVENT_TYPE* findEventByEventID(EVENT e)
 /*							EVENT Creation			                    */
 /************************************************************************/
 
-//We do not need a separate Kernel_Create_Event_Direct function, since creating an event object requires no parameters
-
-EVENT Kernel_Create_Event(void)
+EVENT Kernel_Create_Event_Direct(void)
 {
 	EVENT_TYPE* e;
+	EVENT id;
 	
 	//Make sure the system's events are not at max
 	if(Event_Count >= MAXEVENT)
@@ -62,40 +57,37 @@ EVENT Kernel_Create_Event(void)
 		#endif
 		
 		kernel_raise_error(MAX_OBJECT_ERR);
-		if(KernelActive)
-			Current_Process->request_retval = 0;
 		return 0;
 	}
 	
-	//Create a new Event object
-	e = malloc(sizeof(EVENT_TYPE));
-	ptrlist_add(&EventList, e);
+	//Take a free Event object from the pool
+	e = handle_alloc(&EventTable, &id);
 	++Event_Count;
 	
-	//Assign a new unique ID to the event. Note that the smallest valid Event ID is 1.
-	e->id = ++Last_EventID;
+	//Assign a new unique ID to the event. Note that valid Event IDs are never 0.
+	e->id = id;
 	e->owner = 0;
 	
 	#ifdef DEBUG
-	printf("Event_Init: Created Event %d!\n", Last_EventID);
+	printf("Event_Init: Created Event %d!\n", e->id);
 	#endif
 	
-	
-	if(KernelActive)	
-		Current_Process->request_retval = e->id;
-		
 	return e->id;
 }
 
+void Kernel_Create_Event(void)
+{
+	Syscall_Return(Current_Process, Kernel_Create_Event_Direct());
+}
+
 static void Kernel_Destroy_Event_Internal(EVENT_TYPE *e)
 {
 	//Destroy the event object
+	handle_free(&EventTable, e->id);
 	e->owner = 0;
 	e->count = 0;
 	e->id = 0;
 	
-	free(e);
-	ptrlist_remove(&EventList, ptrlist_find(&EventList, e));
 	--Event_Count;
 }
 
@@ -107,7 +99,7 @@ static void Kernel_Destroy_Event_Internal(EVENT_TYPE *e)
 
 void Kernel_Wait_Event(void)
 {
-	EVENT_TYPE* e = findEventByEventID(Current_Process->request_args[0].val);
+	EVENT_TYPE* e = findEventByEventID(Syscall_Arg_Val(Current_Process, 0));
 	
 	if(e == NULL)
 	{
@@ -144,7 +136,7 @@ void Kernel_Wait_Event(void)
 
 void Kernel_Signal_Event(void)
 {
-	EVENT_TYPE* e = findEventByEventID(Current_Process->request_args[0].val);
+	EVENT_TYPE* e = findEventByEventID(Syscall_Arg_Val(Current_Process, 0));
 	PD *e_owner;
 	
 	if(e == NULL)
@@ -165,7 +157,7 @@ void Kernel_Signal_Event(void)
 	
 	//Wake up the owner of the event by setting its state to READY if it's active. The event is "consumed"
 	e_owner = findProcessByPID(e->owner);
-	e_owner->state = READY;
+	Kernel_Ready_Task(e_owner);
 	Kernel_Destroy_Event_Internal(e);
 		
 	Kernel_Request_Cswitch = 1;
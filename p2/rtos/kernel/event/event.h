@@ -2,6 +2,7 @@
 #define EVENT_H_
 
 #include "../kernel_shared.h"
+#include "../hardware/cpuarch.h"
 
 
 #define MAXEVENT					8
@@ -17,12 +18,9 @@ typedef struct event_type
 } EVENT_TYPE;
 
 
-/*Kernel variables accessible by the OS*/
-extern volatile unsigned int Last_EventID;
-
-
 void Event_Reset();
-EVENT Kernel_Create_Event(void);
+EVENT Kernel_Create_Event_Direct(void);
+void Kernel_Create_Event(void);
 void Kernel_Wait_Event(void);
 void Kernel_Signal_Event(void);
 EVENT_TYPE* findEventByEventID(EVENT e);
@@ -1,34 +1,25 @@
 #include "event_group.h"
-#include <stdlib.h>		//Remove once kmalloc is used
 
-volatile static PtrList EventGroupList;
+#if MAXEVENTGROUP > HANDLE_MAX_SLOTS
+#error "MAXEVENTGROUP is larger than a handle table can hold"
+#endif
+
+static EVENT_GROUP_TYPE Event_Group_Pool[MAXEVENTGROUP];
+static HandleSlot Event_Group_Slots[MAXEVENTGROUP];
+static HandleTable EventGroupTable;				//Maps EVENT_GROUP IDs to the event group objects
 volatile unsigned int Event_Group_Count;
-volatile unsigned int Last_Event_Group_ID;	
 
 
 EVENT_GROUP_TYPE* findEventGroupByID(EVENT_GROUP eg)
 {
-	PtrList *i;
-	EVENT_GROUP_TYPE *eg_i;
-		
-	for(i = &EventGroupList; i; i = i->next)
-	{
-		eg_i = (EVENT_GROUP_TYPE*)i->ptr;
-		if (eg_i->id == eg)
-			return eg_i;
-	}
-		
-	return NULL;
+	return handle_lookup(&EventGroupTable, eg);
 }
 
 
 void Event_Group_Reset(void)
 {
 	Event_Group_Count = 0;
-	Last_Event_Group_ID = 0;
-	
-	EventGroupList.ptr = NULL;
-	EventGroupList.next = NULL;
+	handle_table_init(&EventGroupTable, Event_Group_Slots, Event_Group_Pool, sizeof(EVENT_GROUP_TYPE), MAXEVENTGROUP);
 }
 
 
@@ -36,9 +27,10 @@ void Event_Group_Reset(void)
 /*						EVENT GROUP CREATION	                      */
 /************************************************************************/
 
-unsigned int Kernel_Create_Event_Group(void)
+EVENT_GROUP Kernel_Create_Event_Group_Direct(void)
 {
 	EVENT_GROUP_TYPE *eg;
+	EVENT_GROUP id;
 	
 	//Make sure we're not exceeding the max
 	if(Event_Group_Count >= MAXEVENTGROUP)
@@ -48,41 +40,31 @@ unsigned int Kernel_Create_Event_Group(void)
 		#endif
 		
 		kernel_raise_error(MAX_OBJECT_ERR);
-		if(KernelActive)
-			Current_Process->request_retval = 0;
 		return 0;
 	}
 	
-	//Create a new Event Group object
-	eg = malloc(sizeof(EVENT_GROUP_TYPE));
-	ptrlist_add(&EventGroupList, eg);	
+	//Take a free Event Group object from the pool
+	eg = handle_alloc(&EventGroupTable, &id);
 	++Event_Group_Count;
 	
-	eg->id = ++Last_Event_Group_ID;
+	eg->id = id;
 	eg->events = 0;
+	Kernel_Wait_Queue_Init(&eg->wait_queue);
 	
-	
-	if(KernelActive)
-		Current_Process->request_retval = eg->id;
-		
 	return eg->id;
 }
 
+void Kernel_Create_Event_Group(void)
+{
+	Syscall_Return(Current_Process, Kernel_Create_Event_Group_Direct());
+}
+
 
 void Kernel_Destroy_Event_Group(void)
 {
-	#define req_eg_id		Current_Process->request_args[0].val
+	#define req_eg_id		Syscall_Arg_Val(Current_Process, 0)
 	
-	PtrList *i;
-	EVENT_GROUP_TYPE *eg;
-		
-	//Find the corresponding Semaphore object in the semaphore list
-	for(i = &EventGroupList; i; i = i->next)
-	{
-		eg = (EVENT_GROUP_TYPE*)i->ptr;
-		if (eg->id == req_eg_id)
-			break;
-	}
+	EVENT_GROUP_TYPE *eg = findEventGroupByID(req_eg_id);
 
 	if(!eg)
 	{
@@ -93,10 +75,10 @@ void Kernel_Destroy_Event_Group(void)
 		return;
 	}
 	
-	/*Should we check and make sure the wait queue is empty first?*/
+	//Tasks still waiting on the event group stay blocked until their timeouts expire, if they have any
+	Kernel_Wait_Queue_Detach(&eg->wait_queue);
 	
-	free(eg);
-	ptrlist_remove(&EventGroupList, i);
+	handle_free(&EventGroupTable, eg->id);
 	--Event_Group_Count;
 	
 	
@@ -112,13 +94,12 @@ void Kernel_Destroy_Event_Group(void)
 void Kernel_Event_Group_Set_Bits()
 {
 	//Request args for the kernel call
-	#define req_event_id		Current_Process->request_args[0].val
-	#define req_bits_to_set		Current_Process->request_args[1].val
+	#define req_event_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_bits_to_set		Syscall_Arg_Val(Current_Process, 1)
 	
 	EVENT_GROUP_TYPE *eg = findEventGroupByID(req_event_id);
 	
-	PtrList* i;
-	PD* process_i;
+	PD *p, *next;
 	unsigned int current_events;
 	
 	if(eg == NULL)
@@ -130,42 +111,30 @@ void Kernel_Event_Group_Set_Bits()
 	
 	eg->events |= req_bits_to_set;
 
-	/* Wake up any process that's currently waiting for this event group if:
+	/* Wake up any task waiting on this event group if:
 			-some of its events are ready, and it doesn't require to wait for all to be ready 
 			-OR all of its events being waited on are ready 
 		
-		Maybe use a list instead of directly accessing PDs?
+		Only the group's own waiters are looked at, and readying a task takes it off the wait queue
 	*/
-	
-	#define ps_eventgroup_id	process_i->request_args[0].val
-	#define ps_bits_waiting		process_i->request_args[1].val
-	#define ps_wait_all_bits	process_i->request_args[2].val
-	
-	for(i = &ProcessList; i; i = i->next)
+	for(p = eg->wait_queue.head; p; p = next)
 	{
-		process_i = (PD*)i->ptr;
+		next = p->wait_next;
+		current_events = p->eg_wait_bits & eg->events;
 		
-		if(process_i->state == WAIT_EVENTG && ps_eventgroup_id == eg->id)						
-		{
-			current_events = ps_bits_waiting & eg->events;
-			
-			if((current_events > 0 && !ps_wait_all_bits) || (current_events == ps_bits_waiting))
-				process_i->state = READY;
-		}
+		if((current_events > 0 && !p->eg_wait_all) || (current_events == p->eg_wait_bits))
+			Kernel_Ready_Task(p);
 	}
 	
 	#undef req_event_id		
 	#undef req_bits_to_set	
-	#undef ps_eventgroup_id	
-	#undef ps_bits_waiting
-	#undef ps_wait_all_bits
 }
 
 void Kernel_Event_Group_Clear_Bits()
 {
 	//Request args for the kernel call
-	#define req_event_id		Current_Process->request_args[0].val
-	#define req_bits_to_clear	Current_Process->request_args[1].val
+	#define req_event_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_bits_to_clear	Syscall_Arg_Val(Current_Process, 1)
 	
 	EVENT_GROUP_TYPE *eg = findEventGroupByID(req_event_id);
 	
@@ -185,13 +154,16 @@ void Kernel_Event_Group_Clear_Bits()
 void Kernel_Event_Group_Wait_Bits()
 {
 	//Request args for the kernel call
-	#define req_event_id		Current_Process->request_args[0].val
-	#define req_bits_to_wait	Current_Process->request_args[1].val
-	#define req_wait_all_bits	Current_Process->request_args[2].val
+	#define req_event_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_bits_to_wait	Syscall_Arg_Val(Current_Process, 1)
+	#define req_wait_all_bits	Syscall_Arg_Val(Current_Process, 2)
+	#define req_timeout			Syscall_Arg_Val(Current_Process, 3)
 	
 	EVENT_GROUP_TYPE *eg = findEventGroupByID(req_event_id);
 	unsigned int current_events;
 	
+	Current_Process->request_timeout = req_timeout;
+	
 	if(eg == NULL)
 	{
 		printf("Event_Group_Set_Bits: Event group %d was not found!\n", req_event_id);
@@ -208,19 +180,23 @@ void Kernel_Event_Group_Wait_Bits()
 	if(current_events == req_bits_to_wait)
 		return;
 	
-	//If the event bits are not yet ready, put the process in WAIT_EVENTG state
+	//If the event bits are not yet ready, put the process in WAIT_EVENTG state on the group's wait queue
+	Current_Process->eg_wait_bits = req_bits_to_wait;
+	Current_Process->eg_wait_all = req_wait_all_bits ? 1 : 0;
+	Kernel_Wait_Enqueue(&eg->wait_queue, (PD*)Current_Process);
 	Current_Process->state = WAIT_EVENTG;
 	Kernel_Request_Cswitch = 1;
 	
 	#undef req_event_id
 	#undef req_bits_to_wait
 	#undef req_wait_all_bits
+	#undef req_timeout
 }
 
-unsigned int Kernel_Event_Group_Get_Bits()
+void Kernel_Event_Group_Get_Bits()
 {
 	//Request args for the kernel call
-	#define req_event_id		Current_Process->request_args[0].val
+	#define req_event_id		Syscall_Arg_Val(Current_Process, 0)
 	
 	EVENT_GROUP_TYPE *eg = findEventGroupByID(req_event_id);
 	
@@ -228,11 +204,10 @@ unsigned int Kernel_Event_Group_Get_Bits()
 	{
 		printf("Event_Group_Set_Bits: Event group %d was not found!\n", req_event_id);
 		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-		return 0;
+		return;
 	}
 	
-	Current_Process->request_retval = eg->events;
-	return eg->events;
+	Syscall_Return(Current_Process, eg->events);
 	
 	#undef req_event_id
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define EVENT_GROUP_H_
 
 #include "../kernel_shared.h"
+#include "../hardware/cpuarch.h"
 
 
 #define MAXEVENTGROUP		8
@@ -12,20 +13,21 @@ typedef struct {
 	
 	EVENT_GROUP id;
 	unsigned int events :MAX_EVENT_BITS;
+	WaitQueue wait_queue;					//Each waiter keeps the bits it waits for and its mode in its PD
 	
 } EVENT_GROUP_TYPE;
 
 
 void Event_Group_Reset(void);
-unsigned int Kernel_Create_Event_Group(void);
+EVENT_GROUP Kernel_Create_Event_Group_Direct(void);
+void Kernel_Create_Event_Group(void);
 void Kernel_Destroy_Event_Group(void);
 void Kernel_Event_Group_Set_Bits(void);
 void Kernel_Event_Group_Clear_Bits(void);
 void Kernel_Event_Group_Wait_Bits(void);
-unsigned int Kernel_Event_Group_Get_Bits(void);
+void Kernel_Event_Group_Get_Bits(void);
 
 
 extern volatile unsigned int Event_Group_Count;
-extern volatile unsigned int Last_Event_Group_ID;
 
 #endif /* EVENT_GROUP_H_ */
\ No newline at end of file
@@ -23,6 +23,10 @@ void Kernel_Init_Task_Stack(unsigned char **sp_ptr, taskfuncptr f)
 	*(unsigned char *)sp-- = (((unsigned int)f) >> 8) & 0xff;
 	*(unsigned char *)sp-- = 0x00;
 	
-	//Allocate the stack with enough memory spaces to save the registers needed for ctxswitch
-	*sp_ptr = sp - 34;
+	//Allocate the stack with enough memory spaces for a lean context, which is all a newly created task needs restored
+	sp -= CSWITCH_LEAN_FRAME_SIZE;
+	memset(sp + 1, 0, CSWITCH_LEAN_FRAME_SIZE);		//Stacks aren't zeroed anymore, so clear the registers the task starts with
+	sp[1] = CSWITCH_FRAME_LEAN;
+	sp[2] = 0x00;				//SREG
+	*sp_ptr = sp;
 }
\ No newline at end of file
@@ -5,12 +5,97 @@
 
 
 /*Let the current code enter/exist an atomic, uninterrupted state*/
+#ifdef __AVR__
+
 #define Disable_Interrupt()		asm volatile ("cli"::)
 #define Enable_Interrupt()		asm volatile ("sei"::)
 
+//Constant kernel tables are kept in flash, since const data would otherwise be copied into RAM
+#include <avr/pgmspace.h>
+#define KERNEL_TABLE				PROGMEM
+#define Read_Kernel_Table_Ptr(p)	pgm_read_ptr(p)
+
+/*
+ * System calls. These are all aliases of Enter_Kernel() in cswitch.s. Following the avr-gcc calling convention, the request arrives in r24
+ * and each argument in the next lower register pair (r22:r23, r20:r21, ...), which are then pushed onto the calling task's stack.
+ * The kernel reads them back from the task's saved context, and writes the return value into its saved r24:r25.
+ * Kernel_Syscall_Full() is used from interrupts instead. It also saves the registers an ordinary call is allowed to clobber.
+ */
+extern int Kernel_Syscall0(KERNEL_REQUEST request);
+extern int Kernel_Syscall1(KERNEL_REQUEST request, uintptr_t a0);
+extern int Kernel_Syscall2(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1);
+extern int Kernel_Syscall3(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2);
+extern int Kernel_Syscall4(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3);
+extern int Kernel_Syscall5(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4);
+extern int Kernel_Syscall6(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4, uintptr_t a5);
+extern int Kernel_Syscall_Full(KERNEL_REQUEST request);
+
+//Type of a saved task context, stored right at its sp. Must match FRAME_* in cswitch.s
+#define CSWITCH_FRAME_LEAN			0				//Callee saved and syscall registers only. Saved by voluntary kernel calls
+#define CSWITCH_FRAME_FULL			1				//Every register. Saved when entering the kernel from an interrupt
+#define CSWITCH_LEAN_FRAME_SIZE		28				//r2..r25, r28, r29, SREG and the frame type
+
+//Both frame types end with r2..r25 (r25 last), SREG and the frame type, so r2..r25 can be found the same way in either
+#define Saved_Register(p, n)		((p)->sp[28 - (n)])
+
+#define Syscall_Request(p)			((KERNEL_REQUEST)Saved_Register(p, 24))
+#define Syscall_Arg(p, n)			((uintptr_t)(Saved_Register(p, 22 - 2*(n)) | (Saved_Register(p, 23 - 2*(n)) << 8)))
+#define Syscall_Return(p, v)		do { int _retval = (v); Saved_Register(p, 24) = _retval & 0xff; Saved_Register(p, 25) = (_retval >> 8) & 0xff; } while(0)
+
+#else
+
+//On the host (POSIX) port, the timer tick is delivered as a signal. Blocking it is the equivalent of disabling interrupts
+#include <signal.h>
+#define TICK_SIGNAL				SIGALRM
+
+void Disable_Interrupt(void);
+void Enable_Interrupt(void);
+
+#define KERNEL_TABLE
+#define Read_Kernel_Table_Ptr(p)	(*(p))
+
+/*
+ * System calls. There are no registers to save on the host, so the request and its arguments are stored in a frame at the start of the
+ * task's context (see posix/cpuarch.c), where the kernel reads them the same way it reads the saved registers on the AVR.
+ */
+typedef struct
+{
+	KERNEL_REQUEST request;
+	uintptr_t args[MAX_KERNEL_ARGS];
+	int retval;
+} Syscall_Frame;
+
+int Kernel_Syscall(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4, uintptr_t a5);
+
+#define Kernel_Syscall0(r)							Kernel_Syscall(r, 0, 0, 0, 0, 0, 0)
+#define Kernel_Syscall1(r, a0)						Kernel_Syscall(r, a0, 0, 0, 0, 0, 0)
+#define Kernel_Syscall2(r, a0, a1)					Kernel_Syscall(r, a0, a1, 0, 0, 0, 0)
+#define Kernel_Syscall3(r, a0, a1, a2)				Kernel_Syscall(r, a0, a1, a2, 0, 0, 0)
+#define Kernel_Syscall4(r, a0, a1, a2, a3)			Kernel_Syscall(r, a0, a1, a2, a3, 0, 0)
+#define Kernel_Syscall5(r, a0, a1, a2, a3, a4)		Kernel_Syscall(r, a0, a1, a2, a3, a4, 0)
+#define Kernel_Syscall6(r, a0, a1, a2, a3, a4, a5)	Kernel_Syscall(r, a0, a1, a2, a3, a4, a5)
+#define Kernel_Syscall_Full(r)						Kernel_Syscall0(r)
+
+#define Syscall_Frame_Of(p)			((Syscall_Frame*)(p)->sp)
+
+#define Syscall_Request(p)			(Syscall_Frame_Of(p)->request)
+#define Syscall_Arg(p, n)			(Syscall_Frame_Of(p)->args[n])
+#define Syscall_Return(p, v)		(Syscall_Frame_Of(p)->retval = (v))
+
+#endif
+
+
+
+//Keeps the compiler from moving memory accesses across it. Both ports run on a single core, so this is all the ordering lock-free code needs
+#define Compiler_Barrier()			asm volatile ("" ::: "memory")
+
+
+//Typed views of a syscall argument
+#define Syscall_Arg_Val(p, n)		((int)Syscall_Arg(p, n))
+#define Syscall_Arg_Ptr(p, n)		((void*)Syscall_Arg(p, n))
 
 
-/*Context Switching functions defined in cswitch.s*/
+/*Context Switching functions defined in cswitch.s (or posix/cpuarch.c for the host port)*/
 extern void CSwitch();
 extern void Enter_Kernel();						//Note that Enter_Kernel() and CSwitch() does the same thing in the current implementation
 extern void Exit_Kernel();
@@ -20,4 +105,4 @@ void Kernel_Init_Task_Stack(unsigned char **sp_ptr, taskfuncptr f);
 
 
 
-#endif /* CPUARCH_H_ */
\ No newline at end of file
+#endif /* CPUARCH_H_ */
@@ -25,18 +25,67 @@ SPH    = 0x3E
 SPL    = 0x3D
 EIND   = 0X3C
 
+/*
+  * Frame types, stored on top of every saved task context so Exit_Kernel()
+  * knows how much to restore. Must match CSWITCH_FRAME_* in cpuarch.h
+  */
+FRAME_LEAN = 0
+FRAME_FULL = 1
+
 /*
   * MACROS
   */
 ;
-; Push all registers and then the status register.
-; It is important to keep the order of SAVECTX and RESTORECTX  exactly
-; in reverse. Also, when a new process is created, it is important to 
-; initialize its "initial" context in the same order as SAVECTX.
-;	
-.macro	SAVECTX
+; A task context is saved in up to three parts, deepest first:
+;
+;   SAVE_SCRATCH   r0, r1, r26, r27, r30, r31 and EIND. Only saved by a
+;                  full frame, since a voluntary call lets the callee
+;                  clobber them (r1 is simply cleared again).
+;   SAVE_CALLEE    r28, r29, r2..r17. The registers the ABI expects a
+;                  call to preserve.
+;   SAVE_ARGS      r18..r25. Call-clobbered, but they hold a system
+;                  call's request, arguments and return value.
+;
+; followed by SREG and the frame type. Both frames end with the same
+; parts, so a saved register is at the same offset from sp in either
+; frame. See Saved_Register() in cpuarch.h
+;
+; The kernel only ever enters a task by a call from C, so its own context
+; is just SAVE_CALLEE.
+;
+; It is important to keep the order of each SAVE macro and its RESTORE
+; macro exactly in reverse. Also, when a new process is created, it is
+; important to initialize its "initial" context in the same order.
+;
+.macro	SAVE_SCRATCH
 	push	r0
 	push	r1
+	push	r26
+	push	r27
+	push	r30
+	push	r31
+#ifdef __AVR_HAVE_EIJMP_EICALL__
+	in		r31, EIND		/*Only parts with more than 128K of flash have EIND*/
+	push	r31
+#endif
+.endm
+
+.macro	RESTORE_SCRATCH
+#ifdef __AVR_HAVE_EIJMP_EICALL__
+	pop		r31
+	out		EIND, r31
+#endif
+	pop		r31
+	pop		r30
+	pop		r27
+	pop		r26
+	pop		r1
+	pop		r0
+.endm
+
+.macro	SAVE_CALLEE
+	push	r28
+	push	r29
 	push	r2
 	push	r3
 	push	r4
@@ -53,6 +102,30 @@ EIND   = 0X3C
 	push	r15
 	push	r16
 	push	r17
+.endm
+
+.macro	RESTORE_CALLEE
+	pop		r17
+	pop		r16
+	pop		r15
+	pop		r14
+	pop		r13
+	pop		r12
+	pop		r11
+	pop		r10
+	pop		r9
+	pop		r8
+	pop		r7
+	pop		r6
+	pop		r5
+	pop		r4
+	pop		r3
+	pop		r2
+	pop		r29
+	pop		r28
+.endm
+
+.macro	SAVE_ARGS
 	push	r18
 	push	r19
 	push	r20
@@ -61,66 +134,41 @@ EIND   = 0X3C
 	push	r23
 	push	r24
 	push	r25
-	push	r26
-	push	r27
-	push	r28
-	push	r29
-	push	r30
-	push	r31
-	
-	in		r31, EIND		/*Copy the extended indirect register to R31 once we saved its real content*/
-	push	r31				/*Push EIND into the stack*/
-	in		r31, SREG		/*Copy the flags register into R31*/
-	push	r31				/*Push SREG into the stack*/
+.endm
 
+.macro	RESTORE_ARGS
+	pop		r25
+	pop		r24
+	pop		r23
+	pop		r22
+	pop		r21
+	pop		r20
+	pop		r19
+	pop		r18
 .endm
+
 ;
-; Pop all registers and the status registers
+; Push SREG and the frame type. r31 is free by now in both frames
 ;
-.macro	RESTORECTX
-	pop r31					/*Pop the top of the stack containing SREG into R31*/
-	out SREG,r31			/*Store the content of the popped data back into SREG*/
-	pop r31					/*Pop the top of the stack containing EIND into R31*/
-	out EIND,r31			/*Store the content of the popped data back into EIND*/
-
-	pop	r31					/*Pop the top of the stack containing the original data for R31*/
-	pop	r30
-	pop	r29
-	pop	r28
-	pop	r27
-	pop	r26
-	pop	r25
-	pop	r24
-	pop	r23
-	pop	r22
-	pop	r21
-	pop	r20
-	pop	r19
-	pop	r18
-	pop	r17
-	pop	r16
-	pop	r15
-	pop	r14
-	pop	r13
-	pop	r12
-	pop	r11
-	pop	r10
-	pop	r9
-	pop	r8
-	pop	r7
-	pop	r6
-	pop	r5
-	pop	r4
-	pop	r3
-	pop	r2
-	pop	r1
-	pop	r0
+.macro	SAVE_FRAME_TYPE type
+	in		r31, SREG
+	push	r31
+	ldi		r31, \type
+	push	r31
 .endm
 
         .section .text
         .global CSwitch
         .global Exit_Kernel
         .global Enter_Kernel
+        .global Kernel_Syscall0
+        .global Kernel_Syscall1
+        .global Kernel_Syscall2
+        .global Kernel_Syscall3
+        .global Kernel_Syscall4
+        .global Kernel_Syscall5
+        .global Kernel_Syscall6
+        .global Kernel_Syscall_Full
         .extern  KernelSp
         .extern  CurrentSp
 
@@ -149,7 +197,7 @@ Exit_Kernel:
           * This is the "top" half of CSwitch(), generally called by the kernel.
           * Assume I = 0, i.e., all interrupts are disabled.
           */
-        SAVECTX
+        SAVE_CALLEE
         /* 
           * Now, we have saved the kernel's context.
           * Save the current H/W stack pointer into KernelSp.
@@ -169,8 +217,25 @@ Exit_Kernel:
         /*
           * We are now executing in Cp's stack.
           * Note: at the bottom of the Cp's context is its return address.
+          * The top of it tells us how the context was saved.
           */
-        RESTORECTX
+        pop  r31
+        cpi  r31, FRAME_FULL
+        breq Restore_Full_Frame
+
+        clr  r1               /* The C ABI expects r1 to be 0 */
+        pop  r31
+        out  SREG, r31
+        RESTORE_ARGS
+        RESTORE_CALLEE
+        reti                  /* re-enable all global interrupts */
+
+Restore_Full_Frame:
+        pop  r31
+        out  SREG, r31
+        RESTORE_ARGS
+        RESTORE_CALLEE
+        RESTORE_SCRATCH
         reti         /* re-enable all global interrupts */
 
 
@@ -182,22 +247,54 @@ Exit_Kernel:
   * There are two possibilities how we get here: 
   *  1) Cp explicitly invokes one of the kernel API call stub, which indirectly
   *       invoke Enter_Kernel().
-  *  2) a timer interrupt, which somehow "jumps" into here.
-  * Let us consider case (1) first. You have to figure out how to deal with
-  * timer interrupts yourself.
+  *  2) a timer interrupt, which enters through Kernel_Syscall_Full() instead.
   *
   * Assumption: All interrupts are disabled upon entering here, and
   *     we are still executing on Cp's stack. The return address of
   *     the caller of Enter_Kernel() is on the top of the stack.
   *
   * void Enter_Kernel();
+  *
+  * The Kernel_SyscallN() stubs are the same entry point. Their request and
+  * arguments are already in r24 and r22..r13 when we get here, so SAVE_ARGS
+  * leaves them in Cp's saved context for the kernel to read. The kernel
+  * writes the return value into the saved r24:r25.
+  *
+  * Since these are ordinary calls, only a lean frame is saved.
+  *
+  * int Kernel_SyscallN(KERNEL_REQUEST request, uintptr_t a0, ...);
   */
+Kernel_Syscall0:
+Kernel_Syscall1:
+Kernel_Syscall2:
+Kernel_Syscall3:
+Kernel_Syscall4:
+Kernel_Syscall5:
+Kernel_Syscall6:
 Enter_Kernel:   
         /*
           * This is the "bottom" half of CSwitch(). We are still executing in
           * Cp's context.
           */
-        SAVECTX
+        SAVE_CALLEE
+        SAVE_ARGS
+        SAVE_FRAME_TYPE FRAME_LEAN
+        rjmp Switch_To_Kernel
+
+/*
+  * Same as Kernel_Syscall0(), but saves every register. Used when the
+  * kernel is entered from an interrupt, where the interrupted code didn't
+  * expect any register to be clobbered.
+  *
+  * int Kernel_Syscall_Full(KERNEL_REQUEST request);
+  */
+Kernel_Syscall_Full:
+        SAVE_SCRATCH
+        SAVE_CALLEE
+        SAVE_ARGS
+        SAVE_FRAME_TYPE FRAME_FULL
+
+Switch_To_Kernel:
         /* 
           * Now, we have saved the Cp's context.
           * Save the current H/W stack pointer into CurrentSp.
@@ -217,7 +314,7 @@ Enter_Kernel:
         /*
           * We are now executing in kernel's stack.
           */
-       RESTORECTX
+        RESTORE_CALLEE
         /* 
           * We are ready to return to the caller of CSwitch() (or Exit_Kernel()).
           * Note: We should NOT re-enable interrupts while kernel is running.
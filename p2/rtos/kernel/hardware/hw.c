@@ -2,6 +2,10 @@
 
 
 #define TICK_LENG 625			//The length of a tick = 10ms, using 16Mhz clock and /256 prescsaler
+#define MAX_IDLE_TICKS			(0xFFFF / TICK_LENG)		//Longest period Timer1 can be stretched to while idling
+
+
+volatile static TICK Idle_Ticks;		//Nonzero while Timer1 is stretched for idling. Cleared by the ISR once the period has elapsed
 
 
 /************************************************************************/
@@ -12,6 +16,13 @@ extern void Kernel_Tick_ISR();
 
 ISR(TIMER1_COMPA_vect)
 {
+	//The stretched idle period has elapsed. Timer_Idle() will report the ticks to the kernel itself
+	if(Idle_Ticks)
+	{
+		Idle_Ticks = 0;
+		return;
+	}
+	
 	Kernel_Tick_ISR();
 }
 
@@ -39,6 +50,78 @@ void Timer_init()
 }
 
 
+/*Called by the kernel with interrupts disabled when no tasks are READY.
+  Stretches the current tick to end after the given number of ticks (0 = as long as possible), and sleeps the CPU until then or until another interrupt arrives.
+  Returns the number of ticks that have elapsed, which were not reported through Kernel_Tick_ISR()*/
+TICK Timer_Idle(TICK ticks)
+{
+	TICK elapsed;
+	
+	//A regular tick came in before we got here. Report it and let the kernel check again
+	if(TIFR1 & (1<<OCF1A))
+	{
+		TIFR1 = (1<<OCF1A);
+		return 1;
+	}
+	
+	if(ticks == 0 || ticks > MAX_IDLE_TICKS)
+		ticks = MAX_IDLE_TICKS;
+	
+	//The timer's progress into the current tick is kept, since TCNT1 is not reset
+	Idle_Ticks = ticks;
+	OCR1A = ticks * TICK_LENG;
+	
+	//Timer1 keeps running in idle sleep mode. The instruction after sei() always executes before any interrupt, so we can't miss the wakeup
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	cli();
+	sleep_disable();
+	
+	//The stretched compare match came in after cli(), so TCNT1 has already restarted. Clear it so the ISR doesn't count it as a regular tick
+	if(Idle_Ticks && (TIFR1 & (1<<OCF1A)))
+	{
+		TIFR1 = (1<<OCF1A);
+		Idle_Ticks = 0;
+	}
+	
+	//The full period has elapsed, and the timer has restarted from 0
+	if(!Idle_Ticks)
+		elapsed = ticks;
+	
+	//Another interrupt woke us up early. Count the whole ticks elapsed so far, and carry over the progress into the current one
+	else
+	{
+		Idle_Ticks = 0;
+		elapsed = TCNT1 / TICK_LENG;
+		TCNT1 -= elapsed * TICK_LENG;
+	}
+	
+	OCR1A = TICK_LENG;
+	return elapsed;
+}
+
+
+/************************************************************************/
+/*						Performance Counter                             */
+/************************************************************************/
+
+/*Timer3 free-runs at the CPU clock, so each count is one CPU cycle. Used for measuring kernel overhead*/
+void Perf_Counter_init()
+{
+	TCCR3A = 0;
+	TCCR3B = (1<<CS30);			//Normal mode, no prescaler
+	TCNT3 = 0;
+}
+
+/*The counter wraps around every 65536 cycles, so only measure intervals shorter than that*/
+unsigned int Perf_Counter_Read()
+{
+	return TCNT3;
+}
+
+
 /************************************************************************/
 /*						Enable STDIO redirection                        */
 /************************************************************************/
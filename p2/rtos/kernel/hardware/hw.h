@@ -5,14 +5,26 @@
 #include "cpuarch.h"
 
 //Include any hardware libraries needed
+#ifdef __AVR__
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include "uart/uart.h"
+#else
+#include <signal.h>
+#include <sys/time.h>
+#endif
 
 
 /*Initializing essential hardware components*/
 void Timer_init();
+TICK Timer_Idle(TICK ticks);
 void stdio_init();
 
 
+/*Free running cycle counter for benchmarking*/
+void Perf_Counter_init();
+unsigned int Perf_Counter_Read();
+
+
 #endif /* HW_H_ */
\ No newline at end of file
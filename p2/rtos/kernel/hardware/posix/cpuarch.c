@@ -0,0 +1,169 @@
+/*
+ * Host (POSIX) implementation of the context switching layer, used in place of cswitch.s and ../cpuarch.c.
+ * Each task runs on its own ucontext. The timer tick is a signal, so "interrupts" are emulated by blocking it.
+ *
+ * Task stacks allocated by the kernel are sized for the AVR, which is far too small for the host's libc and signal frames.
+ * Each task is therefore given its own host stack, and the task's sp simply points to its Host_Context.
+ * The context starts with the task's syscall frame, which is where the kernel finds the request and its arguments.
+ */
+
+#include "../cpuarch.h"
+#include <ucontext.h>
+#include <stdlib.h>
+
+
+#define HOST_TASK_STACK_SIZE		(64*1024)
+
+
+typedef struct host_context {
+	Syscall_Frame frame;									//Must be first. See Syscall_Frame_Of() in ../cpuarch.h
+	ucontext_t uc;
+	struct host_context *next_free;							//Contexts of terminated tasks are kept for reuse
+	unsigned char stack[HOST_TASK_STACK_SIZE];
+} Host_Context;
+
+
+extern volatile unsigned char *CurrentSp;
+
+static ucontext_t Kernel_Context;
+static Host_Context *Free_Contexts;
+
+
+
+/************************************************************************/
+/*							Interrupts                                  */
+/************************************************************************/
+
+static void Set_Tick_Signal_Mask(int how)
+{
+	sigset_t s;
+	
+	sigemptyset(&s);
+	sigaddset(&s, TICK_SIGNAL);
+	sigprocmask(how, &s, NULL);
+}
+
+void Disable_Interrupt(void)
+{
+	Set_Tick_Signal_Mask(SIG_BLOCK);
+}
+
+void Enable_Interrupt(void)
+{
+	Set_Tick_Signal_Mask(SIG_UNBLOCK);
+}
+
+
+
+/************************************************************************/
+/*						Initialize task workspace                       */
+/************************************************************************/
+
+//Every task starts here with the tick signal still blocked, and falls into Task_Terminate() if its main function ever returns
+static void Task_Entry(void)
+{
+	Enable_Interrupt();
+	Current_Process->code();
+	Task_Terminate();
+}
+
+void Kernel_Init_Task_Stack(unsigned char **sp_ptr, taskfuncptr f)
+{
+	Host_Context *ctx;
+	
+	//Reuse the context of a terminated task if possible
+	if(Free_Contexts)
+	{
+		ctx = Free_Contexts;
+		Free_Contexts = ctx->next_free;
+	}
+	else
+	{
+		ctx = malloc(sizeof(Host_Context));
+		if(!ctx)
+		{
+			kernel_raise_error(MALLOC_FAILED_ERR);
+			return;
+		}
+	}
+	
+	memset(&ctx->frame, 0, sizeof(ctx->frame));
+	getcontext(&ctx->uc);
+	ctx->uc.uc_stack.ss_sp = ctx->stack;
+	ctx->uc.uc_stack.ss_size = HOST_TASK_STACK_SIZE;
+	ctx->uc.uc_link = NULL;
+	sigaddset(&ctx->uc.uc_sigmask, TICK_SIGNAL);
+	ctx->next_free = NULL;
+	makecontext(&ctx->uc, Task_Entry, 0);
+	
+	*sp_ptr = (unsigned char*)ctx;
+}
+
+
+
+/************************************************************************/
+/*							Context Switching                           */
+/************************************************************************/
+
+//Saves the current task's context and switches to the kernel. Returns once the kernel switches back to the task, with the tick signal still blocked
+static void Switch_To_Kernel(Host_Context *ctx)
+{
+	//A terminating task is never switched back to, so its context can be handed to the next new task
+	if(ctx->frame.request == TASK_TERMINATE)
+	{
+		ctx->next_free = Free_Contexts;
+		Free_Contexts = ctx;
+	}
+	
+	swapcontext(&ctx->uc, &Kernel_Context);
+}
+
+//Called with the tick signal blocked
+void Enter_Kernel()
+{
+	Switch_To_Kernel((Host_Context*)CurrentSp);
+	
+	//Back in the task with its context fully restored, so the tick can safely preempt it again
+	Enable_Interrupt();
+}
+
+//Called with the tick signal blocked. Stores the request in the task's syscall frame, where the kernel expects it, and enters the kernel
+int Kernel_Syscall(KERNEL_REQUEST request, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4, uintptr_t a5)
+{
+	Host_Context *ctx = (Host_Context*)CurrentSp;
+	int retval;
+	
+	ctx->frame.request = request;
+	ctx->frame.args[0] = a0;
+	ctx->frame.args[1] = a1;
+	ctx->frame.args[2] = a2;
+	ctx->frame.args[3] = a3;
+	ctx->frame.args[4] = a4;
+	ctx->frame.args[5] = a5;
+	
+	Switch_To_Kernel(ctx);
+	
+	//Read the return value before unblocking the tick, since a preemption reuses the same frame
+	retval = ctx->frame.retval;
+	Enable_Interrupt();
+	return retval;
+}
+
+/*
+ * Called by the kernel to switch to the task at CurrentSp. Like "reti", the task resumes with the tick signal unblocked.
+ * swapcontext() restores the signal mask before the registers, so the tick must stay blocked in the target context.
+ * Otherwise it could arrive halfway through the switch, and the preemption would save the kernel's registers as the task's context.
+ * The task unblocks it itself once it is running again, in Task_Entry() or on its way out of Enter_Kernel() and Kernel_Syscall().
+ */
+void Exit_Kernel()
+{
+	Host_Context *ctx = (Host_Context*)CurrentSp;
+	
+	sigaddset(&ctx->uc.uc_sigmask, TICK_SIGNAL);
+	swapcontext(&Kernel_Context, &ctx->uc);
+}
+
+void CSwitch()
+{
+	Exit_Kernel();
+}
@@ -0,0 +1,138 @@
+/*
+ * Host (POSIX) implementation of hw.c. The timer tick is driven by setitimer() and delivered as TICK_SIGNAL,
+ * and stdio is left on the process' stdout.
+ */
+
+#include "../hw.h"
+#include <time.h>
+#include <stdio.h>
+
+
+#define MAX_IDLE_TICKS			1000			//Longest period the timer can be stretched to while idling
+
+
+volatile static TICK Idle_Ticks;		//Nonzero while the timer is stretched for idling. Cleared by the handler once the period has elapsed
+
+
+/************************************************************************/
+/*								Timer                                   */
+/************************************************************************/
+
+extern void Kernel_Tick_ISR();
+
+static void Timer_Handler(int sig)
+{
+	//The stretched idle period has elapsed. Timer_Idle() will report the ticks to the kernel itself
+	if(Idle_Ticks)
+	{
+		Idle_Ticks = 0;
+		return;
+	}
+	
+	Kernel_Tick_ISR();
+}
+
+//Arms the timer to first fire after first_usec, then repeat every tick
+static void Timer_Set(long first_usec)
+{
+	struct itimerval t;
+	
+	t.it_value.tv_sec = first_usec / 1000000;
+	t.it_value.tv_usec = first_usec % 1000000;
+	t.it_interval.tv_sec = 0;
+	t.it_interval.tv_usec = MSECPERTICK * 1000L;
+	setitimer(ITIMER_REAL, &t, NULL);
+}
+
+
+/*Sets up the timer needed for task_sleep*/
+void Timer_init()
+{
+	struct sigaction sa;
+	
+	sa.sa_handler = Timer_Handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(TICK_SIGNAL, &sa, NULL);
+	
+	Timer_Set(MSECPERTICK * 1000L);
+	
+	#ifdef DEBUG
+	printf("Timer initialized!\n");
+	#endif
+}
+
+
+/*Called by the kernel with the tick signal blocked when no tasks are READY. See ../hw.c*/
+TICK Timer_Idle(TICK ticks)
+{
+	sigset_t pending, wait_mask;
+	struct itimerval remaining;
+	long elapsed_usec;
+	int sig;
+	TICK elapsed;
+	
+	//A regular tick came in before we got here. Report it and let the kernel check again
+	sigpending(&pending);
+	if(sigismember(&pending, TICK_SIGNAL))
+	{
+		sigemptyset(&wait_mask);
+		sigaddset(&wait_mask, TICK_SIGNAL);
+		sigwait(&wait_mask, &sig);
+		return 1;
+	}
+	
+	if(ticks == 0 || ticks > MAX_IDLE_TICKS)
+		ticks = MAX_IDLE_TICKS;
+	
+	Idle_Ticks = ticks;
+	Timer_Set(ticks * MSECPERTICK * 1000L);
+	
+	//Sleep until any signal arrives
+	sigprocmask(SIG_BLOCK, NULL, &wait_mask);
+	sigdelset(&wait_mask, TICK_SIGNAL);
+	sigsuspend(&wait_mask);
+	
+	//The full period has elapsed, and the timer is already repeating every tick again
+	if(!Idle_Ticks)
+		return ticks;
+	
+	//Another signal woke us up early. Count the whole ticks elapsed so far, and carry over the progress into the current one
+	Idle_Ticks = 0;
+	getitimer(ITIMER_REAL, &remaining);
+	elapsed_usec = ticks * MSECPERTICK * 1000L - (remaining.it_value.tv_sec * 1000000L + remaining.it_value.tv_usec);
+	elapsed = elapsed_usec / (MSECPERTICK * 1000L);
+	Timer_Set(MSECPERTICK * 1000L - elapsed_usec % (MSECPERTICK * 1000L));
+	
+	return elapsed;
+}
+
+
+/************************************************************************/
+/*						Performance Counter                             */
+/************************************************************************/
+
+/*The host has no cycle counter we can rely on, so each count is one nanosecond instead*/
+void Perf_Counter_init()
+{
+}
+
+unsigned int Perf_Counter_Read()
+{
+	struct timespec t;
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned int)(t.tv_sec * 1000000000UL + t.tv_nsec);
+}
+
+
+/************************************************************************/
+/*						Enable STDIO redirection                        */
+/************************************************************************/
+
+void stdio_init()
+{
+	//Output from tasks should show up immediately, even when stdout is redirected to a file
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	printf("STDOUT->HOST!\n");
+}
@@ -3,11 +3,32 @@
 
 /*System variables used by the kernel only*/		
 volatile static unsigned int Tick_Count;							//Number of timer ticks missed
-volatile static PtrList* Last_Dispatched;							//Pointer to the global process queue of the task that was running previously
+volatile static PD* Ready_Queue[LOWEST_PRIORITY+1];					//Head of the circular list of READY tasks for each priority level
+volatile static unsigned int Ready_Bitmap;							//Bit n is set if Ready_Queue[n] has at least one task
+volatile static PD* Timeout_Queue;									//Tasks waiting with a timeout, sorted by expiry. Each timeout is relative to the task before it
+volatile static TICK System_Ticks;									//Total number of ticks processed since the kernel started
+
+#if LOWEST_PRIORITY >= 16
+#error "Ready_Bitmap can only represent up to 16 priority levels"
+#endif
+
+//Index of the lowest set bit, ie. the highest priority level that has a READY task
+#define Find_First_Set(x)	__builtin_ctz(x)
 
 #ifdef PREEMPTIVE_CSWITCH
 volatile static unsigned int Preemptive_Cswitch_Allowed;
-volatile static unsigned int Ticks_Since_Last_Cswitch;
+#endif
+
+#ifdef EDF_SCHEDULING
+#if EDF_PRIORITY > LOWEST_PRIORITY
+#error "EDF_PRIORITY must be a valid priority level"
+#endif
+
+//Compares two deadlines, allowing the tick counter to wrap around. Deadlines must be less than half the TICK range apart
+#define Deadline_Before(a, b)	((TICK)((a) - (b)) > ((TICK)~0 >> 1))
+
+//Tasks that never set a deadline are due after every task that has one, and stay FIFO among themselves
+#define EDF_Due_Before(p, q)	((p)->has_deadline && (!(q)->has_deadline || Deadline_Before((p)->deadline, (q)->deadline)))
 #endif
 
 
@@ -19,10 +40,12 @@ volatile unsigned int KernelActive;									//Indicates if kernel has been initi
 volatile unsigned int Kernel_Request_Cswitch;						//If a kernel request set this variable to 1, the kernel will switch to a different task after the request completes
 volatile ERROR_CODE err;											//Error code for the previous kernel operation (if any)		
 
+#ifdef CSWITCH_PROFILE
+static volatile unsigned int Cswitch_Cycles;						//Cheapest round trip through Exit_Kernel() seen so far
+#endif
+
 
-//uchar Kernel_Heap[KERNEL_HEAP_SIZE];								//Heap for kerel object allocation, used by kmalloc
-//uchar Task_Workspace_Pool[WORKSPACE_HEAP_SIZE];					//Heap for kerel object allocation, used by kmalloc
-//volatile void* Workspace_Pool_End;
+static unsigned char Kernel_Heap[KERNEL_HEAP_SIZE];					//Heap for kernel object allocation, used by kmalloc
 
 
 
@@ -35,36 +58,30 @@ volatile ERROR_CODE err;											//Error code for the previous kernel operatio
 /*Returns the pointer of a process descriptor in the global process list, by searching for its PID*/
 PD* findProcessByPID(int pid)
 {
-	PtrList *i;
-	PD *process_i;
-	
-	//Valid PIDs must be greater than 0.
-	if(pid <= 0)
-		return NULL;
-	
-	for(i = &ProcessList; i; i = i->next)
-	{
-		process_i = (PD*)i->ptr;
-		if (process_i->pid == pid)
-			return process_i;
-	}
-	
-	//No process with such PID
-	return NULL;
+	//Returns NULL if there's no process with such PID
+	return handle_lookup(&ProcessTable, pid);
 }
 
 
 
+static TICK Kernel_Timeout_Remaining(PD *p);
+
 void print_processes()
 {
-	PtrList *i;
+	unsigned char i;
 	PD *process_i;
 	
-	for(i = &ProcessList; i; i = i->next)
+	for(i = handle_first(&ProcessTable); i != HANDLE_NO_SLOT; i = handle_next(&ProcessTable, i))
 	{
-		process_i = (PD*)i->ptr;
-		if(process_i->state != DEAD)
-		printf("\tPID: %d\t State: %d\t Priority: %d\t Timeout: %d\n", process_i->pid, process_i->state, process_i->pri, process_i->request_timeout);
+		process_i = handle_slot_obj(&ProcessTable, i);
+		if(process_i->state == DEAD)
+			continue;
+		
+		printf("\tPID: %d\t State: %d\t Priority: %d\t Timeout: %d", process_i->pid, process_i->state, process_i->pri, Kernel_Timeout_Remaining(process_i));
+		#ifdef PAINT_STACKS
+		printf("\t Stack: %d/%d", (int)Kernel_Stack_Peak(process_i), (int)process_i->stack_size);
+		#endif
+		printf("\n");
 	}
 	printf("\n");
 }
@@ -73,13 +90,87 @@ void print_process(PID p)
 {
 	PD *pd = findProcessByPID(p);
 
-	printf("\tPID: %d\t State: %d\t Priority: %d\t Timeout: %d\n", pd->pid, pd->state, pd->pri, pd->request_timeout);
+	printf("\tPID: %d\t State: %d\t Priority: %d\t Timeout: %d\n", pd->pid, pd->state, pd->pri, Kernel_Timeout_Remaining(pd));
 	printf("\n");
 }
 
 
 
 
+/************************************************************************/
+/*							TIMEOUT QUEUE		                        */
+/************************************************************************/
+
+#define In_Timeout_Queue(p)		((p)->timeout_prev || Timeout_Queue == (p))
+
+//Inserts a task into the timeout queue, using its request_timeout as the number of ticks from now
+static void Kernel_Timeout_Add(PD *p)
+{
+	volatile PD *i;
+	volatile PD *prev = NULL;
+	TICK remaining = p->request_timeout;
+	
+	//Skip past every task expiring no later than p. Tasks with the same expiry keep their FIFO order
+	for(i = Timeout_Queue; i && i->request_timeout <= remaining; i = i->timeout_next)
+	{
+		remaining -= i->request_timeout;
+		prev = i;
+	}
+	
+	p->request_timeout = remaining;
+	p->timeout_prev = (PD*)prev;
+	p->timeout_next = (PD*)i;
+	
+	if(prev)
+		prev->timeout_next = p;
+	else
+		Timeout_Queue = p;
+	
+	//The task after p is now relative to p instead
+	if(i)
+	{
+		i->timeout_prev = p;
+		i->request_timeout -= remaining;
+	}
+}
+
+//Removes a task from the timeout queue and clears its timeout
+static void Kernel_Timeout_Remove(PD *p)
+{
+	//The task after p inherits p's remaining ticks, so its own expiry stays the same
+	if(p->timeout_next)
+	{
+		p->timeout_next->request_timeout += p->request_timeout;
+		p->timeout_next->timeout_prev = p->timeout_prev;
+	}
+	
+	if(p->timeout_prev)
+		p->timeout_prev->timeout_next = p->timeout_next;
+	else
+		Timeout_Queue = p->timeout_next;
+	
+	p->timeout_next = NULL;
+	p->timeout_prev = NULL;
+	p->request_timeout = 0;
+}
+
+//Returns how many ticks are left before a task in the timeout queue expires
+static TICK Kernel_Timeout_Remaining(PD *p)
+{
+	TICK remaining = 0;
+	
+	if(!In_Timeout_Queue(p))
+		return 0;
+	
+	for(; p; p = p->timeout_prev)
+		remaining += p->request_timeout;
+	
+	return remaining;
+}
+
+
+
+
 /************************************************************************/
 /*                  KERNEL TIMER TICK HANDLERS							*/
 /************************************************************************/
@@ -90,117 +181,323 @@ void Kernel_Tick_ISR()
 	//Increment the system-wide missed tick count
 	++Tick_Count;
 	
-	//Preemptive Scheduling: Has it been a long time since we switched to a new task?
+	//Preemptive Scheduling: Has the current task used up its time slice? Tasks with a quantum of 0 are never preempted
+	//An ISR that flagged a consumer above the current task's priority also gets it switched in now, instead of at the next kernel call
 	#ifdef PREEMPTIVE_CSWITCH	
 	if(!Preemptive_Cswitch_Allowed)
 		return;
 		
-	if(++Ticks_Since_Last_Cswitch >= PREEMPTIVE_CSWITCH_FREQ)
+	#ifdef ISR_QUEUE_ENABLED
+	if((Current_Process->quantum && --Current_Process->slice_remaining == 0) || ISR_Queue_Wake_Pri < Current_Process->pri)
+	#else
+	if(Current_Process->quantum && --Current_Process->slice_remaining == 0)
+	#endif
 	{
 		Disable_Interrupt();
-		Current_Process->request = TASK_YIELD;
-		Enter_Kernel();							//Interrupts are automatically enabled once kernel is exited
+		Kernel_Syscall_Full(TASK_YIELD);		//Interrupts are automatically enabled once kernel is exited
 	}
 	#endif
 }
 
-//Processes all tasks that are currently sleeping and decrement their sleep ticks when called. Expired sleep tasks are placed back into their old state
+//Processes any new ticks. Only the head of the timeout queue needs to be decremented, and expired tasks are placed back into their old state
 static void Kernel_Tick_Handler()
 {
-	volatile PtrList *i;
-	volatile PD *process_i;
-	int remaining_ticks;
+	volatile PD *p;
+	TICK elapsed;
 	
 	//No new ticks has been issued yet, skipping...
 	if(Tick_Count == 0)
 		return;
 	
-	for(i = &ProcessList; i; i = i->next)
+	elapsed = Tick_Count;
+	Tick_Count = 0;
+	System_Ticks += elapsed;
+	
+	//Pop every task at the head of the timeout queue that has expired
+	while(Timeout_Queue && Timeout_Queue->request_timeout <= elapsed)
 	{
-		process_i = (PD*)i->ptr;
+		p = Timeout_Queue;
+		elapsed -= p->request_timeout;
+		p->request_timeout = 0;				//Already counted, so none of it is handed to the next task
+		Kernel_Timeout_Remove((PD*)p);
 		
-		//Increment tick count for starvation prevention
-		#ifdef PREVENT_STARVATION
-		if(process_i->state == READY)
-			process_i->starvation_ticks += Tick_Count;
-		#endif
-		
-		//Skip tasks that do not have any outstanding ticks remaining (or at all in the first place)
-		if(process_i->request_timeout == 0)
-			continue;
-		
-		//Decrement the request timeout counter for any tasks having a nonzero counter; wake up any tasks if their counter has reached zero
-		remaining_ticks = process_i->request_timeout - Tick_Count;
-		if(remaining_ticks > 0)
+		if(p->state == SUSPENDED)		//"Thaw" any SUSPENDED tasks but do not wake them up immediately
+			p->last_state = READY;
+		else							//Wake up any other tasks timing out from its request (including sleep). Its return value is how much of the request got done, which is usually 0 for a failure.
 		{
-			process_i->request_timeout = remaining_ticks;
-			continue;
+			Kernel_Ready_Task((PD*)p);
+			Syscall_Return(p, p->request_progress);
 		}
+	}
+	
+	//Every other task's timeout is relative to the head, so they don't need to be touched
+	if(Timeout_Queue)
+		Timeout_Queue->request_timeout -= elapsed;
+}
+
+
+
+/************************************************************************/
+/*							READY QUEUES		                        */
+/************************************************************************/
+
+#ifdef EDF_SCHEDULING
+//Returns the first task in the EDF band due after p, or the head if none are (ie. p goes to the tail). Tasks with the same deadline stay FIFO
+static PD* Kernel_EDF_Position(PD *p, PD *head)
+{
+	PD *i = head;
+	
+	do
+	{
+		if(EDF_Due_Before(p, i))
+			return i;
+		i = i->ready_next;
+	} while(i != head);
+	
+	return head;
+}
+#endif
 
-		process_i->request_timeout = 0;
+//Marks a task as READY and appends it to the tail of the ready queue for its priority. The EDF band is sorted by deadline instead
+void Kernel_Ready_Task(PD *p)
+{
+	volatile PD *head;
+	PD *next;
+	
+	p->state = READY;
+	
+	//The task is no longer waiting for anything, so its timeout is no longer needed
+	if(In_Timeout_Queue(p))
+		Kernel_Timeout_Remove(p);
+	p->request_timeout = 0;
+	
+	//Nor is its place in the wait queue of the object it was blocked on, if it timed out
+	Kernel_Wait_Remove(p);
+	
+	//Already in a ready queue
+	if(p->ready_next)
+		return;
+	
+	#ifdef PREVENT_STARVATION
+	p->ready_tick = System_Ticks;
+	#endif
+	
+	head = Ready_Queue[p->pri];
+	if(!head)
+	{
+		p->ready_next = p;
+		p->ready_prev = p;
+		Ready_Queue[p->pri] = p;
+		Ready_Bitmap |= (1 << p->pri);
+		return;
+	}
+	
+	//The queue is circular, so the tail is right before the head
+	next = (PD*)head;
+	#ifdef EDF_SCHEDULING
+	if(p->pri == EDF_PRIORITY)
+		next = Kernel_EDF_Position(p, (PD*)head);
+	#endif
+	
+	p->ready_next = next;
+	p->ready_prev = next->ready_prev;
+	next->ready_prev->ready_next = p;
+	next->ready_prev = p;
+	
+	//The earliest deadline is always kept at the head, so it's dispatched first
+	#ifdef EDF_SCHEDULING
+	if(p->pri == EDF_PRIORITY && EDF_Due_Before(p, head))
+		Ready_Queue[p->pri] = p;
+	#endif
+}
+
+//Removes a task from its ready queue. Its state is left for the caller to change
+void Kernel_Unready_Task(PD *p)
+{
+	if(!p->ready_next)
+		return;
+	
+	//p is the only task in the queue
+	if(p->ready_next == p)
+	{
+		Ready_Queue[p->pri] = NULL;
+		Ready_Bitmap &= ~(1 << p->pri);
+	}
+	else
+	{
+		p->ready_prev->ready_next = p->ready_next;
+		p->ready_next->ready_prev = p->ready_prev;
 		
-		if(process_i->state == SUSPENDED)		//"Thaw" any SUSPENDED tasks but do not wake them up immediately
-			process_i->last_state = READY;
-		else									//Wake up any other tasks timing out from its request (including sleep), and set its return value to 0 indicate a failure.
-		{
-			process_i->state = READY;
-			process_i->request_retval = 0;
-		}
+		if(Ready_Queue[p->pri] == p)
+			Ready_Queue[p->pri] = p->ready_next;
 	}
 	
-	Tick_Count = 0;
+	p->ready_next = NULL;
+	p->ready_prev = NULL;
 }
 
 
 
 /************************************************************************/
-/*                     KERNEL SCHEDULING FUNCTIONS                      */
+/*							WAIT QUEUES			                        */
 /************************************************************************/
 
-//Look through all ready tasks and select the next task for dispatching
-static PtrList* Kernel_Select_Next_Task()
+void Kernel_Wait_Queue_Init(WaitQueue *q)
 {
-	PtrList *i;
-	PD *process_i;
-	int j;
+	#ifdef PRIORITY_WAIT_QUEUES
+	unsigned int i;
+	
+	for(i=0; i<=LOWEST_PRIORITY; i++)
+		q->level_tail[i] = NULL;
+	#endif
+	
+	q->head = NULL;
+	q->tail = NULL;
+	q->count = 0;
+}
+
+#ifdef PRIORITY_WAIT_QUEUES
+//Inserts a task after the last waiter of its priority, or of the nearest higher priority. Finding it only looks at the priority levels, never at the other waiters
+void Kernel_Wait_Enqueue(WaitQueue *q, PD *p)
+{
+	PD *prev = NULL;
+	int level;
+	
+	for(level = p->pri; level >= 0 && !prev; level--)
+		prev = q->level_tail[level];
+	
+	p->wait_queue = q;
+	p->wait_pri = p->pri;
+	p->wait_prev = prev;
+	p->wait_next = prev ? prev->wait_next : q->head;
+	
+	if(prev)
+		prev->wait_next = p;
+	else
+		q->head = p;
 	
-	PtrList *next_dispatch = NULL;
-	int highest_priority = LOWEST_PRIORITY + 1;	
+	if(p->wait_next)
+		p->wait_next->wait_prev = p;
+	else
+		q->tail = p;
+	
+	q->level_tail[p->wait_pri] = p;
+	++q->count;
+}
+#else
+//Appends a task to the tail of a wait queue. The links are in its PD, so blocking never allocates memory
+void Kernel_Wait_Enqueue(WaitQueue *q, PD *p)
+{
+	p->wait_queue = q;
+	p->wait_next = NULL;
+	p->wait_prev = q->tail;
+	
+	if(q->tail)
+		q->tail->wait_next = p;
+	else
+		q->head = p;
+	
+	q->tail = p;
+	++q->count;
+}
+#endif
+
+//Unlinks a task from the wait queue it's in, if any
+void Kernel_Wait_Remove(PD *p)
+{
+	WaitQueue *q = p->wait_queue;
+	
+	if(!q)
+		return;
+	
+	#ifdef PRIORITY_WAIT_QUEUES
+	//The waiter before it takes over as the last of its priority, if it has the same one
+	if(q->level_tail[p->wait_pri] == p)
+		q->level_tail[p->wait_pri] = (p->wait_prev && p->wait_prev->wait_pri == p->wait_pri) ? p->wait_prev : NULL;
+	#endif
+	
+	if(p->wait_prev)
+		p->wait_prev->wait_next = p->wait_next;
+	else
+		q->head = p->wait_next;
+	
+	if(p->wait_next)
+		p->wait_next->wait_prev = p->wait_prev;
+	else
+		q->tail = p->wait_prev;
+	
+	--q->count;
+	p->wait_queue = NULL;
+	p->wait_next = NULL;
+	p->wait_prev = NULL;
+}
+
+//Pops the task at the head of a wait queue. Returns NULL if the queue is empty
+PD* Kernel_Wait_Dequeue(WaitQueue *q)
+{
+	PD *p = q->head;
+	
+	if(p)
+		Kernel_Wait_Remove(p);
+	
+	return p;
+}
+
+//Unlinks every task from the wait queue of an object being destroyed. They stay blocked until their timeouts expire, if they have any
+void Kernel_Wait_Queue_Detach(WaitQueue *q)
+{
+	while(Kernel_Wait_Dequeue(q));
+}
+
+
+
+/************************************************************************/
+/*                     KERNEL SCHEDULING FUNCTIONS                      */
+/************************************************************************/
+
+//Returns the current system tick, including ticks that haven't been processed yet
+TICK Kernel_Now(void)
+{
+	return System_Ticks + Tick_Count;
+}
+
+//Select the next task for dispatching from the head of the highest non-empty ready queue. In the EDF band, this is the earliest deadline
+static PD* Kernel_Select_Next_Task()
+{
+	PRIORITY highest_priority;
+	PD *next_dispatch;
 	
 	#ifdef PREVENT_STARVATION
-	PtrList *most_starved = NULL;
-	PD *process_ms;
+	PD *most_starved = NULL;
+	PD *head;
+	int j;
 	#endif	
 	
-	//Iterate through every task in the process list, starting from the task AFTER the one that was previously dispatched
-	for(j=0, i = ptrlist_cnext(&ProcessList,Last_Dispatched); j<Task_Count; j++, i = ptrlist_cnext(&ProcessList,i))
+	if(!Ready_Bitmap)
+		return NULL;
+	
+	//Tasks of the same priority are dispatched from the head, and re-enter at the tail (round robin)
+	highest_priority = Find_First_Set(Ready_Bitmap);
+	next_dispatch = (PD*)Ready_Queue[highest_priority];
+	
+	//The head of each lower priority queue has been READY the longest within its level. Record the most starved one.
+	#ifdef PREVENT_STARVATION
+	for(j = highest_priority + 1; j <= LOWEST_PRIORITY; j++)
 	{
-		process_i = (PD*)i->ptr;
-
-		if(process_i->state != READY)
+		if(!(Ready_Bitmap & (1 << j)))
 			continue;
 		
-		//Select the next READY task with the highest priority. If all READY tasks have the same priority, the next task of the same priority is dispatched (round robin)
-		if(process_i->pri < highest_priority)
-		{
-			next_dispatch = i;
-			highest_priority = process_i->pri;
-		}
-			
-		//If a READY task is found to be starving, record it if it has the highest starving count
-		#ifdef PREVENT_STARVATION
-		else if(process_i->starvation_ticks >= STARVATION_MAX)
-		{
-			if(most_starved && process_ms->starvation_ticks <= process_i->starvation_ticks)
-				continue;
+		head = (PD*)Ready_Queue[j];
+		if((TICK)(System_Ticks - head->ready_tick) < STARVATION_MAX)
+			continue;
+		
+		//The earlier it became READY, the more starved it is
+		if(most_starved && (TICK)(System_Ticks - most_starved->ready_tick) >= (TICK)(System_Ticks - head->ready_tick))
+			continue;
 			
-			most_starved = i;
-			process_ms = process_i;
-		}
-		#endif
+		most_starved = head;
 	}
 	
-	#ifdef PREVENT_STARVATION
 	if(most_starved)
 		return most_starved;
 	#endif
@@ -211,12 +508,7 @@ static PtrList* Kernel_Select_Next_Task()
 /* Dispatches a new task */
 static void Kernel_Dispatch_Next_Task()
 {
- 
-	volatile PtrList* i;
-	volatile PD *process_i;
-	unsigned int j;
-	
-	PtrList* next_dispatch;
+	PD* next_dispatch;
 	
 	//Don't allow preemptive cswitch to kick in again while we're waiting for a task to be ready
 	#ifdef PREEMPTIVE_CSWITCH
@@ -224,63 +516,59 @@ static void Kernel_Dispatch_Next_Task()
 	#endif
 	
 	//Mark the current task from RUNNING to READY, so it can be considered by the scheduler again
-	if(Current_Process->state == RUNNING)
-		Current_Process->state = READY;			
+	if(Current_Process && Current_Process->state == RUNNING)
+		Kernel_Ready_Task((PD*)Current_Process);
 	
 	//Check if any timer ticks came in, so more tasks can be ready for dispatching
 	Kernel_Tick_Handler();
 	
+	//Wake the consumers that ISRs have pushed items for
+	#ifdef ISR_QUEUE_ENABLED
+	Kernel_ISR_Queue_Wake();
+	#endif
+	
+	//If the current task is now blocked on a request with a timeout, start counting down from this point on
+	if(Current_Process && Current_Process->state != READY && Current_Process->state != DEAD && Current_Process->request_timeout > 0 && !In_Timeout_Queue(Current_Process))
+		Kernel_Timeout_Add((PD*)Current_Process);
+	
 	//Select a READY task for dispatch
 	next_dispatch = Kernel_Select_Next_Task();
 
 	//When none of the tasks in the process list is ready
 	if(!next_dispatch)
 	{
-		i = Last_Dispatched;
-		process_i = (PD*)i->ptr;
-		j = 0;
-
-		//We'll temporarily re-enable interrupt in case if one or more task is waiting on events/interrupts or sleeping
-		Enable_Interrupt();
-		
-		//Looping through the process list until any process becomes ready
-		while(process_i->state != READY)
-		{			
-			//We only need to check if any timer ticks came in periodically
-			if(++j >= Task_Count*100)
-			{
-				Disable_Interrupt();
-				Kernel_Tick_Handler();
-				j = 0;
-				Enable_Interrupt();
-			}
-
-			i = ptrlist_cnext(&ProcessList,i);
-			process_i = (PD*)i->ptr;
+		//Sleep until the nearest timeout expires (or as long as the timer allows if there are none), then process the ticks that were skipped
+		while(!Ready_Bitmap)
+		{
+			Tick_Count += Timer_Idle(Timeout_Queue? Timeout_Queue->request_timeout : 0);
+			Kernel_Tick_Handler();
+			#ifdef ISR_QUEUE_ENABLED
+			Kernel_ISR_Queue_Wake();			//Any interrupt ends the idle sleep, so an ISR that pushed an item is noticed right away
+			#endif
 		}
 		
-		//Now that we have some ready tasks, interrupts must be disabled for the kernel to function properly again.
-		Disable_Interrupt();
 		next_dispatch = Kernel_Select_Next_Task();	
 	}
 
+	//A periodic task that was parked is starting its released job
+	#ifdef PERIODIC_TASKS
+	if(next_dispatch->job_released)
+		Kernel_Start_Periodic_Job(next_dispatch);
+	#endif
+
 	//Load the next selected task's process descriptor into Current_Process and dispatch it to run 
-	Last_Dispatched = next_dispatch;
-	Current_Process = (PD*)next_dispatch->ptr;
+	Kernel_Unready_Task(next_dispatch);
+	Current_Process = next_dispatch;
 	CurrentSp = Current_Process->sp;
 	Current_Process->state = RUNNING;
 	
 	
-	//Reset Preemptive cswitch
+	//Hand out a new time slice only if the task used up its last one. Otherwise it continues with what it had left
 	#ifdef PREEMPTIVE_CSWITCH
-	Ticks_Since_Last_Cswitch = 0;
+	if(Current_Process->slice_remaining == 0)
+		Current_Process->slice_remaining = Current_Process->quantum;
 	Preemptive_Cswitch_Allowed = 1;
 	#endif
-	
-	//Reset Starvation Count
-	#ifdef PREVENT_STARVATION
-	Current_Process->starvation_ticks = 0;
-	#endif
 }
 
 
@@ -301,6 +589,20 @@ static void Kernel_Invalid_Request()
 }
 
 
+typedef void (*Kernel_Request_Handler)(void);
+
+//Kernel function handling each request, indexed by KERNEL_REQUEST. Generated from KERNEL_REQUESTS in kernel_shared.h
+#define KERNEL_REQUEST_HANDLER(request, handler)	handler,
+
+static const Kernel_Request_Handler Kernel_Request_Handlers[INVALID] KERNEL_TABLE =
+{
+	Kernel_Yield_Task,						//NONE could be caused by a timer interrupt
+	KERNEL_REQUESTS(KERNEL_REQUEST_HANDLER)
+};
+
+#undef KERNEL_REQUEST_HANDLER
+
+
 /**
   * This internal kernel function is the "main" driving loop of this full-served
   * model architecture. Basically, on OS_Start(), the kernel repeatedly
@@ -310,10 +612,23 @@ static void Kernel_Invalid_Request()
   * This is the main loop of our kernel, called by OS_Start().
   */
 
+#ifdef CSWITCH_PROFILE
+/*A task that enters the kernel again right after being switched to makes the cheapest round trip through Exit_Kernel(),
+  which is the cost of leaving and entering the kernel with no kernel work in between. Measured in Perf_Counter_Read() counts*/
+unsigned int Kernel_Get_Cswitch_Cycles()
+{
+	return Cswitch_Cycles;
+}
+#endif
+
 static void Kernel_Main_Loop() 
 {
+	KERNEL_REQUEST request;
+	#ifdef CSWITCH_PROFILE
+	unsigned int cswitch_start, cswitch_cycles;
+	#endif
+	
 	//Select an initial task to run
-	Last_Dispatched = ptrlist_findtail(&ProcessList);
 	Kernel_Dispatch_Next_Task();
 
 	//After OS initialization, THIS WILL BE KERNEL'S MAIN LOOP!
@@ -328,162 +643,22 @@ static void Kernel_Main_Loop()
 		/*																							*/
 		/********************************************************************************************/
 
-		//Save the current task's stack pointer and proceed to handle its request
-		Current_Process->sp = CurrentSp;
+		//Save the current task's stack pointer, which also locates the request and its arguments in the saved context
+		Current_Process->sp = (unsigned char*)CurrentSp;
+		request = Syscall_Request(Current_Process);
 		
 		err = NO_ERR;
+		Current_Process->request_progress = 0;
 
-		//Because each branch only calls a function, this switch statement should hopefully be converted to a jump table by the compiler
-		switch(Current_Process->request)
-		{
-			
-			/*TASK*/
-			case TASK_CREATE:
-			Kernel_Create_Task();
-			break;
-			
-			case TASK_TERMINATE:
-			Kernel_Terminate_Task();
-			break;
-		   
-			case TASK_SUSPEND:
-			Kernel_Suspend_Task();
-			break;
-			
-			case TASK_RESUME:
-			Kernel_Resume_Task();
-			break;
-			
-			case TASK_SLEEP:
-			Kernel_Sleep_Task();					
-			break;
-			
-			
-			/*MUTEX*/
-			#ifdef MUTEX_ENABLED
-			case MUT_CREATE:
-			Kernel_Create_Mutex();
-			break;
-			
-			case MUT_DESTROY:
-			Kernel_Destroy_Mutex();
-			break;
-			
-			case MUT_LOCK:
-			Kernel_Lock_Mutex();
-			break;
-			
-			case MUT_UNLOCK:
-			Kernel_Unlock_Mutex();
-			break;
-			#endif
-			
-			
-			/*SEMAPHORE*/
-			#ifdef SEMAPHORE_ENABLED
-			case SEM_CREATE:
-			Kernel_Create_Semaphore();
-			break;
-			
-			case SEM_DESTROY:
-			Kernel_Destroy_Semaphore();
-			break;
-			
-			case SEM_GIVE:
-			Kernel_Semaphore_Give();
-			break;
-			
-			case SEM_GET:
-			Kernel_Semaphore_Get();
-			break;
-			#endif
-			
-			
-			/*EVENT*/
-			#ifdef EVENT_ENABLED
-			case E_CREATE:
-			Kernel_Create_Event();
-			break;
-			
-			case E_WAIT:
-			Kernel_Wait_Event();
-			break;
-			
-			case E_SIGNAL:
-			Kernel_Signal_Event();
-			break;
-			#endif
-			
-			
-			/*EVENT GROUP*/
-			#ifdef EVENT_GROUP_ENABLED
-			case EG_CREATE:
-			Kernel_Create_Event_Group();
-			break;
-			
-			case EG_DESTROY:
-			Kernel_Destroy_Event_Group();
-			break;
-			
-			case EG_SETBITS:
-			Kernel_Event_Group_Set_Bits();
-			break;
-			
-			case EG_CLEARBITS:
-			Kernel_Event_Group_Clear_Bits();
-			break;
-			
-			case EG_WAITBITS:
-			Kernel_Event_Group_Wait_Bits();
-			break;
-			
-			case EG_GETBITS:
-			Kernel_Event_Group_Get_Bits();
-			break;
-			#endif
-			
-			
-			/*MAILBOX*/
-			#ifdef MAILBOX_ENABLED
-			case MB_CREATE:
-			Kernel_Create_Mailbox();
-			break;
-			
-			case MB_DESTROY:
-			Kernel_Destroy_Mailbox();
-			break;
-			
-			case MB_CHECKMAIL:
-			Kernel_Mailbox_Check();
-			break;
-			
-			case MB_SENDMAIL:
-			Kernel_Mailbox_Send();
-			break;
-			
-			case MB_RECVMAIL:
-			Kernel_Mailbox_Recv();
-			break;
-			
-			case MB_DESTROYM:
-			Kernel_Mailbox_Destroy_Mail();
-			break;
-			#endif
-		   
-		   
-		    /*OTHERS*/
-			case TASK_YIELD:
-			case NONE:							// NONE could be caused by a timer interrupt
-			Kernel_Dispatch_Next_Task();
-			break;
-       
-			default:							//Invalid request code, just ignore
+		//Requests are numbered in the same order as the handler table. Anything out of range is ignored
+		if(request < INVALID)
+			((Kernel_Request_Handler)Read_Kernel_Table_Ptr(&Kernel_Request_Handlers[request]))();
+		else
 			Kernel_Invalid_Request();
-			break;
-       }
 		
-		//Clears the process' request field after it has been handled
-		Current_Process->request = NONE;
+		//A request that didn't block the task doesn't need its timeout
+		if(Current_Process->state == RUNNING)
+			Current_Process->request_timeout = 0;
 		
 		//Switch to a new task if the completed kernel request requires it
 		if(Kernel_Request_Cswitch)
@@ -494,7 +669,16 @@ static void Kernel_Main_Loop()
 		
 		//Load the newly selected task's stack pointer and switch to its context
 		CurrentSp = Current_Process->sp;
+		
+		#ifdef CSWITCH_PROFILE
+		cswitch_start = Perf_Counter_Read();
 		Exit_Kernel();
+		cswitch_cycles = Perf_Counter_Read() - cswitch_start;
+		if(cswitch_cycles < Cswitch_Cycles)
+			Cswitch_Cycles = cswitch_cycles;
+		#else
+		Exit_Kernel();
+		#endif
     } 
 }
 
@@ -506,16 +690,29 @@ static void Kernel_Main_Loop()
 /*This function initializes the RTOS and must be called before any othersystem calls.*/
 void Kernel_Reset()
 {
+	int i;
+	
 	KernelActive = 0;
 	Tick_Count = 0;	
-	Last_Dispatched = NULL;
+	Current_Process = NULL;
 	Kernel_Request_Cswitch = 0;
 	err = NO_ERR;
 	
 	#ifdef PREEMPTIVE_CSWITCH
 	Preemptive_Cswitch_Allowed = 1;
-	Ticks_Since_Last_Cswitch = 0;
 	#endif
+	
+	#ifdef CSWITCH_PROFILE
+	Cswitch_Cycles = (unsigned int)-1;
+	#endif
+	
+	init_kmalloc(Kernel_Heap + KERNEL_HEAP_SIZE, Kernel_Heap);		//The heap grows downwards from the end of the array
+	
+	Timeout_Queue = NULL;
+	System_Ticks = 0;
+	Ready_Bitmap = 0;
+	for(i=0; i<=LOWEST_PRIORITY; i++)
+		Ready_Queue[i] = NULL;
 
 	Task_Reset();
 	
@@ -539,6 +736,10 @@ void Kernel_Reset()
 	Mailbox_Reset();
 	#endif
 	
+	#ifdef ISR_QUEUE_ENABLED
+	ISR_Queue_Reset();
+	#endif
+	
 	#ifdef DEBUG
 	printf("OS initialized!\n");
 	#endif
@@ -559,6 +760,10 @@ void Kernel_Start()
 		/*Initialize and start Timer needed for sleep*/
 		Timer_init();
 		
+		#ifdef CSWITCH_PROFILE
+		Perf_Counter_init();
+		#endif
+		
 		#ifdef DEBUG
 		printf("OS begins!\n");
 		#endif
@@ -35,6 +35,10 @@
 #include "mailbox/mailbox.h"
 #endif
 
+#ifdef ISR_QUEUE_ENABLED
+#include "queue/isr_queue.h"
+#endif
+
 
 
 /************************************************************************/
@@ -50,6 +54,12 @@ void Kernel_Start();
 void Kernel_Tick_ISR();
 
 
+/*Profiling*/
+#ifdef CSWITCH_PROFILE
+unsigned int Kernel_Get_Cswitch_Cycles();
+#endif
+
+
 /*Debug*/
 void print_processes();
 void print_process(PID p);
@@ -7,12 +7,13 @@
 
 #include "../os.h"			//will also include kernel.h
 #include "kernel_errors.h"
-#include "others/PtrList.h"
+#include "others/HandleTable.h"
+#include "others/kmalloc.h"
 #include <stdio.h>
 #include <string.h>
 
 
-#define MAX_KERNEL_ARGS		5
+#define MAX_KERNEL_ARGS		6				//Most arguments a system call can pass to the kernel. See hardware/cpuarch.h
 
 
 /************************************************************************/
@@ -35,80 +36,167 @@ typedef enum
 	WAIT_EVENTG,
 	WAIT_MUTEX,
 	WAIT_SEMAPHORE,
-	WAIT_MAILBOX
+	WAIT_MAILBOX,
+	WAIT_ISR_QUEUE
 	
 } PROCESS_STATE;
 
 
+/*
+ * Every kernel request and the kernel function that handles it. KERNEL_REQUEST and the kernel's dispatch table are both generated from this list,
+ * so a request is added by adding one X(request, handler) entry to its module's list. Lists of disabled modules are left empty.
+ */
+#define TASK_REQUESTS(X)				\
+	X(TASK_CREATE, Kernel_Create_Task)		\
+	X(TASK_YIELD, Kernel_Yield_Task)		\
+	X(TASK_TERMINATE, Kernel_Terminate_Task)	\
+	X(TASK_SUSPEND, Kernel_Suspend_Task)		\
+	X(TASK_RESUME, Kernel_Resume_Task)		\
+	X(TASK_SLEEP, Kernel_Sleep_Task)
+
+#ifdef PREEMPTIVE_CSWITCH
+#define QUANTUM_REQUESTS(X)				\
+	X(TASK_SET_QUANTUM, Kernel_Set_Task_Quantum)
+#else
+#define QUANTUM_REQUESTS(X)
+#endif
+
+#ifdef PAINT_STACKS
+#define STACK_REQUESTS(X)				\
+	X(TASK_STACK_USAGE, Kernel_Get_Task_Stack_Usage)
+#else
+#define STACK_REQUESTS(X)
+#endif
+
+#ifdef EDF_SCHEDULING
+#define EDF_REQUESTS(X)					\
+	X(TASK_SET_DEADLINE, Kernel_Set_Task_Deadline)
+#else
+#define EDF_REQUESTS(X)
+#endif
+
+#ifdef PERIODIC_TASKS
+#define PERIODIC_REQUESTS(X)				\
+	X(TASK_CREATE_PERIODIC, Kernel_Create_Periodic_Task)	\
+	X(TASK_WAIT_PERIOD, Kernel_Wait_Next_Period)
+#else
+#define PERIODIC_REQUESTS(X)
+#endif
+
+#ifdef EVENT_ENABLED
+#define EVENT_REQUESTS(X)				\
+	X(E_CREATE, Kernel_Create_Event)		\
+	X(E_WAIT, Kernel_Wait_Event)			\
+	X(E_SIGNAL, Kernel_Signal_Event)
+#else
+#define EVENT_REQUESTS(X)
+#endif
+
+#ifdef EVENT_GROUP_ENABLED
+#define EVENT_GROUP_REQUESTS(X)				\
+	X(EG_CREATE, Kernel_Create_Event_Group)		\
+	X(EG_DESTROY, Kernel_Destroy_Event_Group)	\
+	X(EG_SETBITS, Kernel_Event_Group_Set_Bits)	\
+	X(EG_CLEARBITS, Kernel_Event_Group_Clear_Bits)	\
+	X(EG_WAITBITS, Kernel_Event_Group_Wait_Bits)	\
+	X(EG_GETBITS, Kernel_Event_Group_Get_Bits)
+#else
+#define EVENT_GROUP_REQUESTS(X)
+#endif
+
+#ifdef MUTEX_ENABLED
+#define MUTEX_REQUESTS(X)				\
+	X(MUT_CREATE, Kernel_Create_Mutex)		\
+	X(MUT_DESTROY, Kernel_Destroy_Mutex)		\
+	X(MUT_LOCK, Kernel_Lock_Mutex)			\
+	X(MUT_UNLOCK, Kernel_Unlock_Mutex)
+#else
+#define MUTEX_REQUESTS(X)
+#endif
+
+#ifdef SEMAPHORE_ENABLED
+#define SEMAPHORE_REQUESTS(X)				\
+	X(SEM_CREATE, Kernel_Create_Semaphore)		\
+	X(SEM_DESTROY, Kernel_Destroy_Semaphore)	\
+	X(SEM_GIVE, Kernel_Semaphore_Give)		\
+	X(SEM_GET, Kernel_Semaphore_Get)
+#else
+#define SEMAPHORE_REQUESTS(X)
+#endif
+
+#ifdef MAILBOX_ENABLED
+#define MAILBOX_REQUESTS(X)				\
+	X(MB_CREATE, Kernel_Create_Mailbox)		\
+	X(MB_DESTROY, Kernel_Destroy_Mailbox)		\
+	X(MB_DESTROYM, Kernel_Mailbox_Destroy_Mail)	\
+	X(MB_CHECKMAIL, Kernel_Mailbox_Check)		\
+	X(MB_SENDMAIL, Kernel_Mailbox_Send)		\
+	X(MB_SENDBUF, Kernel_Mailbox_Send)		\
+	X(MB_SENDMANY, Kernel_Mailbox_Send)		\
+	X(MB_RECVMANY, Kernel_Mailbox_Recv)		\
+	X(MB_ALLOCBUF, Kernel_Mailbox_Alloc_Buffer)	\
+	X(MB_FREEBUF, Kernel_Mailbox_Free_Buffer)	\
+	X(MB_RECVMAIL, Kernel_Mailbox_Recv)
+#else
+#define MAILBOX_REQUESTS(X)
+#endif
+
+#ifdef ISR_QUEUE_ENABLED
+#define ISR_QUEUE_REQUESTS(X)				\
+	X(ISRQ_CREATE, Kernel_Create_ISR_Queue)		\
+	X(ISRQ_DESTROY, Kernel_Destroy_ISR_Queue)	\
+	X(ISRQ_WAIT, Kernel_ISR_Queue_Wait)
+#else
+#define ISR_QUEUE_REQUESTS(X)
+#endif
+
+#define KERNEL_REQUESTS(X)	\
+	TASK_REQUESTS(X)		\
+	QUANTUM_REQUESTS(X)		\
+	STACK_REQUESTS(X)		\
+	EDF_REQUESTS(X)			\
+	PERIODIC_REQUESTS(X)	\
+	EVENT_REQUESTS(X)		\
+	EVENT_GROUP_REQUESTS(X)	\
+	MUTEX_REQUESTS(X)		\
+	SEMAPHORE_REQUESTS(X)	\
+	MAILBOX_REQUESTS(X)		\
+	ISR_QUEUE_REQUESTS(X)
+
+
 /*Definitions for all available kernel requests.*/
+#define KERNEL_REQUEST_ENUM(request, handler)	request,
+
 typedef enum 
 {
 	NONE = 0,
 	
-	/*TASK*/
-	TASK_CREATE,
-	TASK_YIELD,
-	TASK_TERMINATE,
-	TASK_SUSPEND,
-	TASK_RESUME,
-	TASK_SLEEP,
-	
-	/*EVENT*/
-	#ifdef EVENT_ENABLED
-	E_CREATE,
-	E_WAIT,
-	E_SIGNAL,
-	#endif
-	
-	/*EVENT GROUP*/
-	#ifdef EVENT_GROUP_ENABLED
-	EG_CREATE,
-	EG_DESTROY,
-	EG_SETBITS,
-	EG_CLEARBITS,
-	EG_WAITBITS,
-	EG_GETBITS,
-	#endif
-	
-	/*MUTEX*/
-	#ifdef MUTEX_ENABLED
-	MUT_CREATE,
-	MUT_DESTROY,
-	MUT_LOCK,
-	MUT_UNLOCK,
-	#endif
-	
-	/*SEMAPHORE*/
-	#ifdef SEMAPHORE_ENABLED
-	SEM_CREATE,
-	SEM_DESTROY,
-	SEM_GIVE,
-	SEM_GET,  
-	#endif
-	
-	/*MAILBOX*/
-	#ifdef MAILBOX_ENABLED
-	MB_CREATE,
-	MB_DESTROY,
-	MB_DESTROYM,
-	MB_CHECKMAIL,
-	MB_SENDMAIL,
-	MB_RECVMAIL,
-	#endif
+	KERNEL_REQUESTS(KERNEL_REQUEST_ENUM)
 	
 	INVALID					//Not an actual request. do not use!
 	
 } KERNEL_REQUEST;
 
+#undef KERNEL_REQUEST_ENUM
+
 
 /************************************************************************/
 /*                         Process Descriptor                           */
 /************************************************************************/
 
-typedef union {
-	int val;
-	void* ptr;
-} Kernel_Arg;
+/*FIFO of the tasks blocked on a kernel object. It's linked through the PDs, since a task waits on at most one object at a time.
+With PRIORITY_WAIT_QUEUES it's sorted by priority instead, and FIFO only among tasks of the same priority*/
+typedef struct {
+	
+	struct ProcessDescriptor *head;
+	struct ProcessDescriptor *tail;
+	unsigned int count;
+	#ifdef PRIORITY_WAIT_QUEUES
+	struct ProcessDescriptor *level_tail[LOWEST_PRIORITY+1];	//Last waiter of each priority, or NULL if none are waiting at it
+	#endif
+	
+} WaitQueue;
+
 
 typedef struct ProcessDescriptor
 { 
@@ -119,6 +207,9 @@ typedef struct ProcessDescriptor
 	size_t stack_size;									//Total size of the stack in bytes
 	unsigned char *stack;								//The origin location of where the stack was allocated at (ie, start of the stack)
 	unsigned char *sp;									//The task's current stack pointer, relative to the task's current context
+	#ifdef PAINT_STACKS
+	size_t stack_peak;									//Most bytes of stack the task had used, as of the last time it was measured
+	#endif
 	taskfuncptr code;									//The function to be executed when this process is running.
 	   
 	   
@@ -126,11 +217,9 @@ typedef struct ProcessDescriptor
 	int arg;												//User specified arg for the task 
 	   
 	   
-	/*Used to pass requests from task to kernel*/
-	KERNEL_REQUEST request;								//What the task want the kernel to do (when needed).
-	Kernel_Arg request_args[MAX_KERNEL_ARGS];	//What values are needed for the specified kernel request.
-	int request_retval;										//Value returned by the kernel after handling the request
-	TICK request_timeout;						
+	/*Requests, their arguments and return values are passed in the task's saved context. See hardware/cpuarch.h*/
+	TICK request_timeout;									//Ticks before the request times out. While in the timeout queue, it's relative to the task before it
+	unsigned int request_progress;							//Work a request has done before blocking, like mails moved in a batch. Returned if it times out
 	   
 	   
 	/*Used for task suspension/resuming*/
@@ -138,8 +227,48 @@ typedef struct ProcessDescriptor
 	   
 	   
 	/*Used for other scheduling modes*/
+	#ifdef PREEMPTIVE_CSWITCH
+	TICK quantum;											//Length of the task's time slice in ticks. 0 if it should never be preempted
+	TICK slice_remaining;									//Ticks left in the current slice. Kept while the task is blocked, so unused time carries over
+	#endif
+	
+	#ifdef EDF_SCHEDULING
+	TICK deadline;											//Absolute system tick of the task's next deadline. Only used in the EDF band
+	unsigned char has_deadline;								//Set once the task calls Task_Set_Deadline(). Until then, it runs FIFO behind the tasks that have
+	#endif
+	
+	#ifdef PERIODIC_TASKS
+	TICK period;											//Ticks between releases of a periodic task. 0 if the task isn't periodic
+	TICK next_release;										//Absolute system tick at which the task's next job is released
+	TICK max_jitter;										//Longest delay so far between a job's release and its dispatch
+	unsigned int overruns;									//Number of jobs released late, because the previous job hadn't finished in time
+	unsigned char job_released;								//Set when a parked task's job is released. Cleared once the job is dispatched
+	#endif
+	
 	#ifdef PREVENT_STARVATION
-	unsigned int starvation_ticks;
+	TICK ready_tick;										//System tick at which the task last became READY
+	#endif
+	
+	
+	/*Links for the scheduler's per-priority ready queue. Both are NULL if the task isn't in a ready queue*/
+	struct ProcessDescriptor *ready_next;
+	struct ProcessDescriptor *ready_prev;
+	
+	/*Links for the kernel's timeout queue, sorted by expiry*/
+	struct ProcessDescriptor *timeout_next;
+	struct ProcessDescriptor *timeout_prev;
+	
+	/*Links for the wait queue of the kernel object the task is blocked on. wait_queue is NULL if the task isn't in one*/
+	WaitQueue *wait_queue;
+	struct ProcessDescriptor *wait_next;
+	struct ProcessDescriptor *wait_prev;
+	PRIORITY wait_orig_pri;									//Priority the task had before it waited on a mutex and inherited the waiters' priority
+	#ifdef EVENT_GROUP_ENABLED
+	unsigned int eg_wait_bits;								//Event group bits the task is waiting for
+	unsigned char eg_wait_all;								//1 if it waits for all of them, 0 if any one of them will do
+	#endif
+	#ifdef PRIORITY_WAIT_QUEUES
+	PRIORITY wait_pri;										//Priority the task was sorted by in its wait queue. Inheritance can change pri while it waits
 	#endif
 	   
 } PD;
@@ -151,7 +280,7 @@ typedef struct ProcessDescriptor
 /************************************************************************/
 
 //These kernel variables are accessible by other kernel modules and the OS internally
-extern volatile PtrList ProcessList;
+extern HandleTable ProcessTable;
 extern volatile PD* Current_Process;	
 extern volatile unsigned int KernelActive;
 extern volatile unsigned int Kernel_Request_Cswitch;	
@@ -164,6 +293,14 @@ extern volatile ERROR_CODE err;
 /************************************************************************/
 
 PD* findProcessByPID(int pid);
+void Kernel_Ready_Task(PD *p);
+void Kernel_Unready_Task(PD *p);
+void Kernel_Wait_Queue_Init(WaitQueue *q);
+void Kernel_Wait_Enqueue(WaitQueue *q, PD *p);
+PD* Kernel_Wait_Dequeue(WaitQueue *q);
+void Kernel_Wait_Remove(PD *p);
+void Kernel_Wait_Queue_Detach(WaitQueue *q);
+TICK Kernel_Now(void);
 
 
 #endif /* KERNEL_INTERNAL_H_ */
\ No newline at end of file
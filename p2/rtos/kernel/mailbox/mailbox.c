@@ -1,28 +1,28 @@
 #include "mailbox.h"
 #include <string.h>
-#include <stdlib.h>		//Remove once kmalloc is used
 #include <stdio.h>
 
-volatile PtrList MailboxList;
+#if MAXMAILBOX > HANDLE_MAX_SLOTS
+#error "MAXMAILBOX is larger than a handle table can hold"
+#endif
+
+static MAILBOX_TYPE Mailbox_Pool[MAXMAILBOX];
+static HandleSlot Mailbox_Slots[MAXMAILBOX];
+static HandleTable MailboxTable;				//Maps MAILBOX IDs to the mailbox objects
 volatile unsigned int Mailbox_Count;
-volatile unsigned int Last_MailboxID;
 
 
 
 void Mailbox_Reset(void)
 {
 	Mailbox_Count = 0;
-	Last_MailboxID = 0;
-	
-	MailboxList.ptr = NULL;
-	MailboxList.next = NULL;
+	handle_table_init(&MailboxTable, Mailbox_Slots, Mailbox_Pool, sizeof(MAILBOX_TYPE), MAXMAILBOX);
 }
 
 
 MAILBOX_TYPE* findMailboxByID(MAILBOX mb)
 {
-	PtrList *i;
-	MAILBOX_TYPE *mb_i;
+	MAILBOX_TYPE *mailbox;
 	
 	//Ensure the request event ID is > 0
 	if(mb <= 0)
@@ -34,15 +34,77 @@ MAILBOX_TYPE* findMailboxByID(MAILBOX mb)
 		return NULL;
 	}
 	
-	for(i = &MailboxList; i; i = i->next)
+	mailbox = handle_lookup(&MailboxTable, mb);
+	if(!mailbox)
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
+	
+	return mailbox;
+}
+
+#define Ring_Slot(mb, i)		((MAIL_SLOT*)((mb)->ring + (i) * (mb)->slot_stride))
+#define Mail_Slot_Data(s)		((void*)((unsigned char*)(s) + MAIL_SLOT_HEADER))
+
+
+//Frees every unread mail in a mailbox, along with its message. A ring mailbox only forgets them
+static void Mailbox_Free_Mails(MAILBOX_TYPE *mb)
+{
+	MAIL_BUFFER *b;
+	
+	mb->ring_head = 0;
+	while(mb->mail_head)
 	{
-		mb_i = (MAILBOX_TYPE*)i->ptr;
-		if (mb_i->id == mb)
-			return mb_i;
+		b = mb->mail_head;
+		mb->mail_head = b->next;
+		kfree(b);
 	}
 	
-	kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-	return NULL;
+	mb->mail_tail = NULL;
+	mb->mail_count = 0;
+}
+
+//Allocates a buffer with room for size bytes of payload, owned by the task p
+static MAIL_BUFFER* Mail_Buffer_Alloc(PD *p, size_t size)
+{
+	MAIL_BUFFER *b = kmalloc(MAIL_BUFFER_HEADER + size);
+	
+	if(!b)
+	{
+		kernel_raise_error(MALLOC_FAILED_ERR);
+		return NULL;
+	}
+	
+	b->next = NULL;
+	b->owner = p->pid;
+	b->source = p->pid;
+	b->size = size;
+	return b;
+}
+
+//Finds the buffer holding a payload. Returns NULL if ptr isn't a mail buffer, or the task p doesn't own it
+static MAIL_BUFFER* Mail_Buffer_Find(PD *p, void *ptr)
+{
+	MAIL_BUFFER *b;
+	
+	if(!ptr || !kmalloc_in_heap(Mail_Buffer_Of(ptr)))
+	{
+		#ifdef DEBUG
+		printf("Mail_Buffer_Find: %p is not a mail buffer\n", ptr);
+		#endif
+		kernel_raise_error(INVALID_ARG_ERR);
+		return NULL;
+	}
+	
+	b = Mail_Buffer_Of(ptr);
+	if(b->owner != p->pid)
+	{
+		#ifdef DEBUG
+		printf("Mail_Buffer_Find: PID %d doesn't own the mail buffer at %p\n", p->pid, ptr);
+		#endif
+		kernel_raise_error(INVALID_ARG_ERR);
+		return NULL;
+	}
+	
+	return b;
 }
 
 
@@ -53,9 +115,13 @@ MAILBOX_TYPE* findMailboxByID(MAILBOX mb)
 /*							Mailbox Creation		                    */
 /************************************************************************/
 
-MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity)
+//A slot_size of 0 creates a mailbox that allocates every mail. Otherwise all capacity slots of slot_size bytes are allocated now, so sending never allocates
+MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity, size_t slot_size)
 {
 	MAILBOX_TYPE* mb;
+	MAILBOX id;
+	unsigned char *ring = NULL;
+	size_t slot_stride = 0;
 	
 	//Make sure the system's events are not at max
 	if(Mailbox_Count >= MAXMAILBOX)
@@ -68,19 +134,49 @@ MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity)
 		return 0;
 	}
 	
-	//Create a new Event object
-	mb = malloc(sizeof(MAILBOX_TYPE));
-	ptrlist_add(&MailboxList, mb);
+	if(slot_size)
+	{
+		if(capacity == 0)
+		{
+			#ifdef DEBUG
+			printf("Kernel_Create_Mailbox: Failed to create Mailbox. A ring mailbox needs at least one slot.\n");
+			#endif
+			
+			kernel_raise_error(INVALID_ARG_ERR);
+			return 0;
+		}
+		
+		slot_stride = (MAIL_SLOT_HEADER + slot_size + KMALLOC_ALIGN - 1) / KMALLOC_ALIGN * KMALLOC_ALIGN;
+		ring = kmalloc(slot_stride * capacity);
+		if(!ring)
+		{
+			#ifdef DEBUG
+			printf("Kernel_Create_Mailbox: Failed to create Mailbox. No room for %d slots of %d bytes.\n", capacity, (int)slot_size);
+			#endif
+			
+			kernel_raise_error(MALLOC_FAILED_ERR);
+			return 0;
+		}
+	}
+	
+	//Take a free Mailbox object from the pool
+	mb = handle_alloc(&MailboxTable, &id);
 	++Mailbox_Count;
 	
-	mb->id = ++Last_MailboxID;
+	mb->id = id;
 	mb->capacity = capacity;
-	mb->mails = new_ptr_queue();
-	mb->send_queue = new_ptr_queue();
-	mb->recv_queue = new_ptr_queue();
+	mb->mail_head = NULL;
+	mb->mail_tail = NULL;
+	mb->mail_count = 0;
+	mb->ring = ring;
+	mb->slot_size = slot_size;
+	mb->slot_stride = slot_stride;
+	mb->ring_head = 0;
+	Kernel_Wait_Queue_Init(&mb->send_queue);
+	Kernel_Wait_Queue_Init(&mb->recv_queue);
 	
 	#ifdef DEBUG
-	printf("Kernel_Create_Mailbox: Created Mailbox %d!\n", Last_MailboxID);
+	printf("Kernel_Create_Mailbox: Created Mailbox %d!\n", mb->id);
 	#endif
 	
 	
@@ -90,28 +186,21 @@ MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity)
 
 void Kernel_Create_Mailbox(void)
 {
-	#define req_capacity		Current_Process->request_args[0].val
+	#define req_capacity		Syscall_Arg_Val(Current_Process, 0)
+	#define req_slot_size		Syscall_Arg(Current_Process, 1)
 	
-	Current_Process->request_retval = Kernel_Create_Mailbox_Direct(req_capacity);
+	Syscall_Return(Current_Process, Kernel_Create_Mailbox_Direct(req_capacity, req_slot_size));
 	
 	#undef req_capacity
+	#undef req_slot_size
 }
 
 
 void Kernel_Destroy_Mailbox(void)
 {
-	#define req_mb_id		Current_Process->request_args[0].val
-		
-	PtrList *i;
-	MAILBOX_TYPE *mb;
+	#define req_mb_id		Syscall_Arg_Val(Current_Process, 0)
 		
-	//Find the corresponding mailbox object in the mailbox list
-	for(i = &MailboxList; i; i = i->next)
-	{
-		mb = (MAILBOX_TYPE*)i->ptr;
-		if (mb->id == req_mb_id)
-		break;
-	}
+	MAILBOX_TYPE *mb = findMailboxByID(req_mb_id);
 
 	if(!mb)
 	{
@@ -122,12 +211,12 @@ void Kernel_Destroy_Mailbox(void)
 		return;
 	}
 	
-	free_queue(&mb->mails);					//Destroy all pending mail 
-	free_queue(&mb->send_queue);			//Destroy send and recv queue. Should we check if both queues are empty first?
-	free_queue(&mb->recv_queue);
-	free_queue(&mb->mails);
-	free(mb);
-	ptrlist_remove(&MailboxList, i);
+	Mailbox_Free_Mails(mb);					//Destroy all pending mail 
+	Kernel_Wait_Queue_Detach(&mb->send_queue);			//Detach the send and recv queue. Should we check if both queues are empty first?
+	Kernel_Wait_Queue_Detach(&mb->recv_queue);
+	if(mb->ring)
+		kfree(mb->ring);
+	handle_free(&MailboxTable, mb->id);
 	--Mailbox_Count;
 		
 	#undef req_mb_id
@@ -136,11 +225,10 @@ void Kernel_Destroy_Mailbox(void)
 
 void Kernel_Mailbox_Destroy_Mail(void)
 {
-	#define req_mail_dest Current_Process->request_args[0].ptr
+	#define req_mail_dest Syscall_Arg_Ptr(Current_Process, 0)
 	
 	MAIL* m = req_mail_dest;
-	
-	/*Should we also check if the mail requested is still an unread mail sitting in a mailbox???*/
+	MAIL_BUFFER *b;
 	
 	if(!m)
 	{
@@ -148,92 +236,308 @@ void Kernel_Mailbox_Destroy_Mail(void)
 		printf("Kernel_Mailbox_Destroy_Mail: Attempted to destroy invalid mail\n");
 		#endif
 		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-		Current_Process->request_retval = 0;
+		Syscall_Return(Current_Process, 0);
+		return;
+	}
+	
+	//Unread mails have no owner, so they can't be destroyed from here
+	b = Mail_Buffer_Find((PD*)Current_Process, m->ptr);
+	if(!b)
+	{
+		Syscall_Return(Current_Process, 0);
+		return;
 	}
 	
-	free(m->ptr);
+	b->owner = 0;							//A stale pointer to the payload must fail the ownership check, rather than free the block again
+	kfree(b);
 	m->ptr = NULL;
 	m->size = 0;
 	m->source = 0;
 	
-	Current_Process->request_retval = 1;
+	Syscall_Return(Current_Process, 1);
 	
 	#undef req_mail_dest
 }
 
 
+//Gives the calling task a buffer it can fill in place and pass to Mailbox_Send_Buffer(), so the message is never copied
+void Kernel_Mailbox_Alloc_Buffer(void)
+{
+	#define req_size		Syscall_Arg(Current_Process, 0)
+	#define req_buf_dest	((void**)Syscall_Arg_Ptr(Current_Process, 1))
+	
+	MAIL_BUFFER *b = Mail_Buffer_Alloc((PD*)Current_Process, req_size);
+	
+	*req_buf_dest = b ? Mail_Buffer_Data(b) : NULL;
+	Syscall_Return(Current_Process, b != NULL);
+	
+	#undef req_size
+	#undef req_buf_dest
+}
+
+
+//Frees a buffer the calling task owns, but never sent
+void Kernel_Mailbox_Free_Buffer(void)
+{
+	#define req_buf			Syscall_Arg_Ptr(Current_Process, 0)
+	
+	MAIL_BUFFER *b = Mail_Buffer_Find((PD*)Current_Process, req_buf);
+	
+	if(b)
+	{
+		b->owner = 0;						//See Kernel_Mailbox_Destroy_Mail()
+		kfree(b);
+	}
+	Syscall_Return(Current_Process, b != NULL);
+	
+	#undef req_buf
+}
+
+
 
 
 
 /************************************************************************/
-/*							 SENDING Operations			                */
+/*							Moving Mails			                    */
 /************************************************************************/
 
-static int Kernel_Mailbox_Recv_Internal(PD* receiver, MAILBOX_TYPE* mb, MAIL* dest, unsigned int blocking_recv);
-void Kernel_Mailbox_Recv_From_Queue(MAILBOX_TYPE* mb);
+/*
+ * Every send and receive request is a batch. Mailbox_Send_Many() and Mailbox_Recv_Many() ask for count mails, and wait until at
+ * least min_count of them have moved. A single send or receive is a batch of one, which only waits for it if it's blocking.
+ * All sends lay out their arguments alike, and so do all receives, so the request of a blocked task is resumed from its saved
+ * arguments. Its request_progress counts the mails it has moved so far.
+ */
+#define Request_Count(p)		(Syscall_Request(p) == MB_SENDMANY || Syscall_Request(p) == MB_RECVMANY ? (unsigned int)Syscall_Arg(p, 5) : 1)
+
+#define Send_Msg(p)				((unsigned char*)Syscall_Arg_Ptr(p, 1) + (p)->request_progress * Syscall_Arg(p, 2))
+#define Send_Size(p)			((size_t)Syscall_Arg(p, 2))
+#define Send_Min(p)				((unsigned int)Syscall_Arg(p, 3))
+#define Send_Zero_Copy(p)		(Syscall_Request(p) == MB_SENDBUF)
+
+#define Recv_Dest(p)			((MAIL*)Syscall_Arg_Ptr(p, 1) + (p)->request_progress)
+#define Recv_Min(p)				((unsigned int)Syscall_Arg(p, 2))
+#define Recv_Buf(mb, p)			((unsigned char*)Syscall_Arg_Ptr(p, 4) + (p)->request_progress * (mb)->slot_size)
+
+
+static void Kernel_Mailbox_Send_From_Queue(MAILBOX_TYPE *mb);
+#ifndef MAILBOX_HAND_OFF
+static int Kernel_Mailbox_Take(PD* receiver, MAILBOX_TYPE* mb);
+#endif
+
+
+//Counts a mail moved for a task blocked on the mailbox. It's woken once it has moved as many as it waits for, or all it asked for
+static void Kernel_Mailbox_Moved(PD *p, unsigned int min_count)
+{
+	++p->request_progress;
+	if(p->request_progress < min_count && p->request_progress < Request_Count(p))
+		return;
+	
+	Syscall_Return(p, p->request_progress);
+	Kernel_Ready_Task(p);					//Also takes it off the wait queue
+}
+
+//Wakes a blocked sender whose next mail couldn't be allocated. It gets back how many it has sent, instead of waiting for the heap to free up
+static void Kernel_Mailbox_Out_Of_Memory(PD *p)
+{
+	Syscall_Return(p, p->request_progress);
+	Kernel_Ready_Task(p);
+}
 
 
-static int Kernel_Mailbox_Send_Internal(PD* sender_pd, MAILBOX_TYPE* mb, void* msg_ptr, size_t msg_size, unsigned int blocking_send)
+#ifdef MAILBOX_HAND_OFF
+//Passes the sender's next mail straight to the receiver, without queueing it in the mailbox. A ring mailbox copies it into the
+//receiver's buffer, a zero-copy send hands over its buffer, and otherwise the message is copied into a new buffer for the receiver
+static int Kernel_Mailbox_Hand_Off(PD* sender_pd, PD* receiver, MAILBOX_TYPE* mb)
 {
-	MAIL *m;
+	MAIL *dest = Recv_Dest(receiver);
+	MAIL_BUFFER *b;
+	void *buf;
 	
-	//Check if the mailbox still have free space left
-	if(mb->mails.count >= mb->capacity)
+	if(mb->ring)
+	{
+		buf = Recv_Buf(mb, receiver);
+		memcpy(buf, Send_Msg(sender_pd), Send_Size(sender_pd));
+	}
+	else
 	{
-		//Return immediately with an error if an async operation was requested
-		if(!blocking_send)
+		if(Send_Zero_Copy(sender_pd))
+			b = Mail_Buffer_Of(Send_Msg(sender_pd));
+		else
 		{
-			#ifdef DEBUG
-			printf("Mailbox Full, cannot send at this time...\n");
-			#endif
-			return 0;
+			b = Mail_Buffer_Alloc(receiver, Send_Size(sender_pd));
+			if(!b)
+				return 0;
+			memcpy(Mail_Buffer_Data(b), Send_Msg(sender_pd), Send_Size(sender_pd));
 		}
 		
-		//If blocking operation was specified, put the sender into a wait state until a free slot has opened up
-		printf("Mailbox full. Putting PID %d into the wait queue...\n", sender_pd->pid);
-		enqueue_ptr(&mb->send_queue, sender_pd);
-		sender_pd->state = WAIT_MAILBOX;
+		b->owner = receiver->pid;
+		b->source = sender_pd->pid;
+		b->size = Send_Size(sender_pd);
+		buf = Mail_Buffer_Data(b);
+	}
+	
+	dest->ptr = buf;
+	dest->size = Send_Size(sender_pd);
+	dest->source = sender_pd->pid;
+	return 1;
+}
+#endif
+
+
+//Results of Kernel_Mailbox_Put()
+#define MAIL_PUT_FULL			0				//No room for the mail. The sender may wait for a receive to make some
+#define MAIL_PUT_DONE			1
+#define MAIL_PUT_NO_MEMORY		(-1)			//The mail's buffer couldn't be allocated, and MALLOC_FAILED_ERR is raised. Waiting won't help
+
+//Moves the sender's next mail to a waiting receiver, or into the mailbox
+static int Kernel_Mailbox_Put(PD* sender_pd, MAILBOX_TYPE* mb)
+{
+	PD *receiver = mb->recv_queue.head;
+	MAIL_BUFFER *b;
+	MAIL_SLOT *s;
+	unsigned int slot;
+	
+	//A receiver only waits while the mailbox is empty, so the mail can go straight to it
+	#ifdef MAILBOX_HAND_OFF
+	if(receiver)
+	{
+		if(!Kernel_Mailbox_Hand_Off(sender_pd, receiver, mb))
+			return MAIL_PUT_NO_MEMORY;
 		
-		Kernel_Request_Cswitch = 1;
-		return -1;
+		Kernel_Mailbox_Moved(receiver, Recv_Min(receiver));
+		return MAIL_PUT_DONE;
 	}
+	#endif
 	
-	//Allocate a new MAIL object, and copy the specified message/data into it
-	m = malloc(sizeof(MAIL));
-	m->source = sender_pd->pid;
-	m->size = msg_size;
-	m->ptr = malloc(msg_size);
+	if(mb->mail_count >= mb->capacity)
+		return MAIL_PUT_FULL;
 	
-	if(!m->ptr)
+	//A ring mailbox copies the message into the slot after the newest mail
+	if(mb->ring)
 	{
-		kernel_raise_error(MALLOC_FAILED_ERR);
+		slot = mb->ring_head + mb->mail_count;
+		if(slot >= mb->capacity)
+			slot -= mb->capacity;
+		
+		s = Ring_Slot(mb, slot);
+		s->source = sender_pd->pid;
+		s->size = Send_Size(sender_pd);
+		memcpy(Mail_Slot_Data(s), Send_Msg(sender_pd), Send_Size(sender_pd));
+	}
+	
+	//Otherwise the mail needs a buffer, unless the sender handed over its own
+	else
+	{
+		if(Send_Zero_Copy(sender_pd))
+			b = Mail_Buffer_Of(Send_Msg(sender_pd));
+		else
+		{
+			b = Mail_Buffer_Alloc(sender_pd, Send_Size(sender_pd));
+			if(!b)
+				return MAIL_PUT_NO_MEMORY;
+			memcpy(Mail_Buffer_Data(b), Send_Msg(sender_pd), Send_Size(sender_pd));
+		}
+		
+		//The mailbox holds the buffer until it's received
+		b->owner = 0;
+		b->source = sender_pd->pid;
+		b->size = Send_Size(sender_pd);
+		
+		//Add the new MAIL to the tail of the mailbox
+		b->next = NULL;
+		if(mb->mail_tail)
+			mb->mail_tail->next = b;
+		else
+			mb->mail_head = b;
+		mb->mail_tail = b;
+	}
+	++mb->mail_count;
+	
+	//Without hand-offs, a waiting receiver takes the mail back out of the mailbox
+	#ifndef MAILBOX_HAND_OFF
+	if(receiver && Kernel_Mailbox_Take(receiver, mb))
+		Kernel_Mailbox_Moved(receiver, Recv_Min(receiver));
+	#endif
+	
+	return MAIL_PUT_DONE;
+}
+
+
+//Moves the oldest mail in the mailbox, or the next mail of a waiting sender, to the receiver. Returns 0 if there's none
+static int Kernel_Mailbox_Take(PD* receiver, MAILBOX_TYPE* mb)
+{
+	#ifdef MAILBOX_HAND_OFF
+	PD *sender_pd = mb->send_queue.head;
+	#endif
+	MAIL *dest = Recv_Dest(receiver);
+	MAIL_BUFFER *b;
+	MAIL_SLOT *s;
+	
+	//A sender can only be waiting on an empty mailbox if it has no slots at all. Its mail goes straight to the receiver
+	if(mb->mail_count == 0)
+	{
+		#ifdef MAILBOX_HAND_OFF
+		if(!sender_pd)
+			return 0;
+		
+		if(!Kernel_Mailbox_Hand_Off(sender_pd, receiver, mb))
+		{
+			Kernel_Mailbox_Out_Of_Memory(sender_pd);
+			return 0;
+		}
+		
+		Kernel_Mailbox_Moved(sender_pd, Send_Min(sender_pd));
+		return 1;
+		#else
 		return 0;
+		#endif
+	}
+	
+	//Copy the oldest mail out of its slot, which can then take a new mail
+	if(mb->ring)
+	{
+		s = Ring_Slot(mb, mb->ring_head);
+		dest->ptr = Recv_Buf(mb, receiver);
+		dest->size = s->size;
+		dest->source = s->source;
+		memcpy(dest->ptr, Mail_Slot_Data(s), s->size);
+		
+		if(++mb->ring_head == mb->capacity)
+			mb->ring_head = 0;
+		--mb->mail_count;
 	}
-	memcpy(m->ptr, msg_ptr, msg_size);
 	
-	//Add the new MAIL into the mailbox queue
-	enqueue_ptr(&mb->mails, m);
+	//Pop the oldest MAIL. Its message now belongs to the receiver, until it calls Mailbox_Destroy_Mail()
+	else
+	{
+		b = mb->mail_head;
+		mb->mail_head = b->next;
+		if(!mb->mail_head)
+			mb->mail_tail = NULL;
+		--mb->mail_count;
+		
+		b->owner = receiver->pid;
+		dest->ptr = Mail_Buffer_Data(b);
+		dest->size = b->size;
+		dest->source = b->source;
+	}
 	
-	//If anyone is currently waiting for the recv queue, wake them up
-	if(mb->recv_queue.count > 0)
-		Kernel_Mailbox_Recv_From_Queue(mb);
+	//If anyone is currently waiting for the send queue, mail it out
+	if(mb->send_queue.count > 0)
+		Kernel_Mailbox_Send_From_Queue(mb);
 	
 	return 1;
 }
 
 
-//Called by Kernel_Mailbox_Get_Mail
-static inline void Kernel_Mailbox_Send_From_Queue(MAILBOX_TYPE *mb)
+//Called when a receive frees a slot. Moves the mails of blocked senders into the mailbox, oldest first
+static void Kernel_Mailbox_Send_From_Queue(MAILBOX_TYPE *mb)
 {
-	#define req_msg_ptr		sender_pd->request_args[1].ptr
-	#define req_msg_size	sender_pd->request_args[2].val
-	
 	PD* sender_pd;
+	int put;
 	
-	while(mb->send_queue.count > 0 && mb->mails.count < mb->capacity)
+	while((sender_pd = mb->send_queue.head) && mb->mail_count < mb->capacity)
 	{
-		sender_pd = dequeue_ptr(&mb->send_queue);
-		
 		if(sender_pd->state != WAIT_MAILBOX)
 		{
 			#ifdef DEBUG
@@ -243,29 +547,42 @@ static inline void Kernel_Mailbox_Send_From_Queue(MAILBOX_TYPE *mb)
 			return;
 		}
 		
-		Kernel_Mailbox_Send_Internal(sender_pd, mb, req_msg_ptr, req_msg_size, 0);
-		
-		//Wake up the task after finish sending
-		sender_pd->state = READY;
+		put = Kernel_Mailbox_Put(sender_pd, mb);
+		if(put == MAIL_PUT_FULL)
+			return;
 		
+		//Wake up the task once it has sent enough, or right away if its mail couldn't be allocated
+		if(put == MAIL_PUT_NO_MEMORY)
+			Kernel_Mailbox_Out_Of_Memory(sender_pd);
+		else
+			Kernel_Mailbox_Moved(sender_pd, Send_Min(sender_pd));
 	}
-	
-	#undef req_msg_ptr
-	#undef req_msg_size
 }
 
 
 
+
+
+/************************************************************************/
+/*							 SENDING Operations			                */
+/************************************************************************/
+
+//Handles Mailbox_Send(), Mailbox_Send_Buffer() and Mailbox_Send_Many(), and their blocking versions
 void Kernel_Mailbox_Send(void)
 {
-	#define req_mb_id		Current_Process->request_args[0].val
-	#define req_msg_ptr		Current_Process->request_args[1].ptr
-	#define req_msg_size	Current_Process->request_args[2].val
-	#define req_blocking	Current_Process->request_args[3].val
-	//req_timeout is also used for blocking operations
+	#define req_mb_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_msg_ptr		Syscall_Arg_Ptr(Current_Process, 1)
+	#define req_msg_size	Send_Size(sender_pd)
+	#define req_min_count	Send_Min(sender_pd)
+	#define req_timeout		Syscall_Arg_Val(Current_Process, 4)
 	
+	PD *sender_pd = (PD*)Current_Process;
 	MAILBOX_TYPE *mb = findMailboxByID(req_mb_id);
-	int retval;
+	MAIL_BUFFER *b;
+	unsigned int count = Request_Count(sender_pd);
+	int put = MAIL_PUT_DONE;
+	
+	Current_Process->request_timeout = req_timeout;
 	
 	if(!mb)
 	{
@@ -273,115 +590,88 @@ void Kernel_Mailbox_Send(void)
 		printf("Kernel_Mailbox_Send_Mail: The requested Mailbox %d was not found!\n", req_mb_id);
 		#endif
 		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-		Current_Process->request_retval = 0;
+		Syscall_Return(Current_Process, 0);
 		return;
 	}
-
-	retval = Kernel_Mailbox_Send_Internal(Current_Process, mb, req_msg_ptr, req_msg_size, req_blocking);
 	
-	if(retval >= 0)	
-		Current_Process->request_retval = retval;		//Don't return -1, as it indicates a pending blocking op
-
-	#undef req_mb_id
-	#undef req_msg_ptr
-	#undef req_msg_size
-	#undef req_blocking
-}
-
-
-
-
-
-
-
-
-
-/************************************************************************/
-/*							RECEIVING Operations			            */
-/************************************************************************/
-
-static int Kernel_Mailbox_Recv_Internal(PD* receiver, MAILBOX_TYPE* mb, MAIL* dest, unsigned int blocking_recv)
-{
-	MAIL *m;
+	//A bad buffer or message fails right away, instead of after blocking
+	if(mb->ring && (Send_Zero_Copy(sender_pd) || req_msg_size > mb->slot_size))
+	{
+		#ifdef DEBUG
+		printf("Kernel_Mailbox_Send: Mailbox %d only takes copies of messages up to %d bytes\n", mb->id, (int)mb->slot_size);
+		#endif
+		kernel_raise_error(INVALID_ARG_ERR);
+		Syscall_Return(Current_Process, 0);
+		return;
+	}
 	
-	if(mb->mails.count == 0)
+	if(Send_Zero_Copy(sender_pd))
 	{
-		//Return immediately if an async operation was requested
-		if(!blocking_recv)
+		b = Mail_Buffer_Find(sender_pd, req_msg_ptr);
+		if(!b || req_msg_size > b->size)
 		{
 			#ifdef DEBUG
-			printf("Mailbox is empty...\n");
+			if(b)
+				printf("Kernel_Mailbox_Send: A %d byte message doesn't fit its %d byte buffer\n", (int)req_msg_size, b->size);
 			#endif
-			
-			dest->ptr = NULL;
-			dest->size = 0;
-			dest->source = 0;
-			return 0;
+			kernel_raise_error(INVALID_ARG_ERR);
+			Syscall_Return(Current_Process, 0);
+			return;
 		}
-		
-		//If blocking operation was specified, put the sender into a wait state until a free slot has opened up
-		printf("Mailbox is empty. Putting PID %d into the wait queue...\n", Current_Process->pid);
-		enqueue_ptr(&mb->recv_queue, Current_Process);
-		Current_Process->state = WAIT_MAILBOX;
-
-		Kernel_Request_Cswitch = 1;
-		return -1;
 	}
 	
-	m = dequeue_ptr(&mb->mails);
-	dest->ptr = m->ptr;
-	dest->size = m->size;
-	dest->source = m->source;
-	free(m);
-	
-	//If anyone is currently waiting for the send queue, mail it out
-	if(mb->send_queue.count > 0)
-		Kernel_Mailbox_Send_From_Queue(mb);
-	
-	return 1;	
-}
-
-
-void Kernel_Mailbox_Recv_From_Queue(MAILBOX_TYPE* mb)
-{
-	#define req_mail_dest		receiver_pd->request_args[1].ptr
+	//Send as many mails as there is room for
+	while(sender_pd->request_progress < count && (put = Kernel_Mailbox_Put(sender_pd, mb)) == MAIL_PUT_DONE)
+		++sender_pd->request_progress;
 	
-	PD* receiver_pd;
-	
-	while(mb->recv_queue.count > 0 && mb->mails.count > 0)
+	//Running out of heap is reported right away, since nothing but a receive would ever retry a blocked sender
+	if(put == MAIL_PUT_NO_MEMORY || sender_pd->request_progress >= req_min_count || sender_pd->request_progress == count)
 	{
-		receiver_pd = dequeue_ptr(&mb->recv_queue);
-		
-		if(receiver_pd->state != WAIT_MAILBOX)
-		{
-			#ifdef DEBUG
-			printf("Kernel_Mailbox_Recv_Mail_From_Queue: Head of the wait queue isn't in WAIT_MAILBOX state!\n");
-			#endif
-			kernel_raise_error(UNPROCESSABLE_TASK_STATE_ERR);
-			return;
-		}
-		
-		Kernel_Mailbox_Recv_Internal(receiver_pd, mb, req_mail_dest, 0);
-		
-		//Wake up the task after finish sending
-		receiver_pd->state = READY;
+		#ifdef DEBUG
+		if(put == MAIL_PUT_NO_MEMORY)
+			printf("Kernel_Mailbox_Send: Out of heap for the mail's buffer\n");
+		else if(sender_pd->request_progress < count)
+			printf("Mailbox Full, cannot send at this time...\n");
+		#endif
 		
+		Syscall_Return(Current_Process, sender_pd->request_progress);
+		return;
 	}
 	
-	#undef req_mail_dest
+	//Put the sender into a wait state until the receivers have made room for enough of its mails
+	Kernel_Wait_Enqueue(&mb->send_queue, sender_pd);
+	sender_pd->state = WAIT_MAILBOX;
+	Kernel_Request_Cswitch = 1;
+
+	#undef req_mb_id
+	#undef req_msg_ptr
 	#undef req_msg_size
+	#undef req_min_count
+	#undef req_timeout
 }
 
 
+
+
+
+/************************************************************************/
+/*							RECEIVING Operations			            */
+/************************************************************************/
+
+//Handles Mailbox_Recv(), Mailbox_Recv_Copy() and Mailbox_Recv_Many(), and their blocking versions
 void Kernel_Mailbox_Recv(void)
 {
-	#define req_mb_id		Current_Process->request_args[0].val
-	#define req_mail_dest	Current_Process->request_args[1].ptr
-	#define req_blocking	Current_Process->request_args[2].val
-	//req_timeout is also used for blocking operations
+	#define req_mb_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_mail_dest	((MAIL*)Syscall_Arg_Ptr(Current_Process, 1))
+	#define req_min_count	Recv_Min(receiver)
+	#define req_timeout		Syscall_Arg_Val(Current_Process, 3)
+	#define req_buf			Syscall_Arg_Ptr(Current_Process, 4)
 	
+	PD *receiver = (PD*)Current_Process;
 	MAILBOX_TYPE *mb = findMailboxByID(req_mb_id);
-	int retval;
+	unsigned int count = Request_Count(receiver);
+	
+	Current_Process->request_timeout = req_timeout;
 	
 	if(!mb)
 	{
@@ -390,21 +680,66 @@ void Kernel_Mailbox_Recv(void)
 		#endif
 		
 		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-		Current_Process->request_retval = 0;
+		Syscall_Return(Current_Process, 0);
 		return;
 	}
 	
-	retval = Kernel_Mailbox_Recv_Internal(Current_Process, mb, req_mail_dest, req_blocking);
+	//Mails of a ring mailbox can only be copied out into a buffer, and only they can
+	if(!mb->ring != !req_buf)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Mailbox_Recv: Mailbox %d %s\n", req_mb_id, mb->ring ? "must be received into a buffer" : "can't be received into a buffer");
+		#endif
+		
+		kernel_raise_error(INVALID_ARG_ERR);
+		Syscall_Return(Current_Process, 0);
+		return;
+	}
 	
-	if(retval >= 0)
-		Current_Process->request_retval = retval;		//Don't return -1, as it indicates a pending blocking op
+	//Receive as many mails as there are
+	while(receiver->request_progress < count && Kernel_Mailbox_Take(receiver, mb))
+		++receiver->request_progress;
+	
+	if(receiver->request_progress >= req_min_count || receiver->request_progress == count)
+	{
+		if(receiver->request_progress == 0)
+		{
+			#ifdef DEBUG
+			printf("Mailbox is empty...\n");
+			#endif
+			
+			req_mail_dest->ptr = NULL;
+			req_mail_dest->size = 0;
+			req_mail_dest->source = 0;
+		}
+		
+		Syscall_Return(Current_Process, receiver->request_progress);
+		return;
+	}
+	
+	//Put the receiver into a wait state until enough mails have arrived
+	Kernel_Wait_Enqueue(&mb->recv_queue, receiver);
+	receiver->state = WAIT_MAILBOX;
+	Kernel_Request_Cswitch = 1;
 	
 	#undef req_mb_id
 	#undef req_mail_dest
-	#undef req_blocking
+	#undef req_min_count
+	#undef req_timeout
+	#undef req_buf
 }
 
 
+#undef Request_Count
+#undef Send_Msg
+#undef Send_Size
+#undef Send_Min
+#undef Send_Zero_Copy
+#undef Recv_Dest
+#undef Recv_Min
+#undef Recv_Buf
+
+
 
 /************************************************************************/
 /*							Other Operations				            */
@@ -412,7 +747,7 @@ void Kernel_Mailbox_Recv(void)
 
 void Kernel_Mailbox_Check(void)
 {
-	#define req_mb_id		Current_Process->request_args[0].val
+	#define req_mb_id		Syscall_Arg_Val(Current_Process, 0)
 	
 	MAILBOX_TYPE *mb = findMailboxByID(req_mb_id);
 	
@@ -422,10 +757,15 @@ void Kernel_Mailbox_Check(void)
 		printf("Kernel_Mailbox_Check_Mail: The requested Mailbox %d was not found!\n", req_mb_id);
 		#endif
 		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-		Current_Process->request_retval = 0;
+		Syscall_Return(Current_Process, 0);
 		return;
 	}
-	Current_Process->request_retval = mb->mails.count;
+	Syscall_Return(Current_Process, mb->mail_count);
 	
 	#undef req_mb_id
 }
+
+
+
+#undef Ring_Slot
+#undef Mail_Slot_Data
@@ -2,7 +2,7 @@
 #define MAILBOX_H_
 
 #include "../kernel_shared.h"
-#include "../others/Queue.h"
+#include "../hardware/cpuarch.h"
 
 #define MAXMAILBOX					8
 
@@ -16,29 +16,64 @@ typedef struct MAIL{
 } MAIL;
 
 
+/*
+ * Every message lives in a MAIL_BUFFER, with its payload right after the header. Unread mails are linked into their mailbox
+ * through the header, so no separate list node is needed. A buffer belongs to one task at a time: the one that allocated or
+ * received it. Only its owner can send it on or destroy it.
+ */
+typedef struct MAIL_BUFFER{
+	
+	struct MAIL_BUFFER *next;				//Next unread mail in the mailbox
+	PID owner;								//0 while the mail waits in a mailbox
+	PID source;
+	unsigned int size;						//Payload size in bytes
+	
+} MAIL_BUFFER;
+
+#define MAIL_BUFFER_HEADER		((sizeof(MAIL_BUFFER) + KMALLOC_ALIGN - 1) / KMALLOC_ALIGN * KMALLOC_ALIGN)	//Keeps the payload aligned
+#define Mail_Buffer_Data(b)		((void*)((unsigned char*)(b) + MAIL_BUFFER_HEADER))
+#define Mail_Buffer_Of(ptr)		((MAIL_BUFFER*)((unsigned char*)(ptr) - MAIL_BUFFER_HEADER))
+
+
+/*A slot of a ring mailbox. The message is copied in right after it*/
+typedef struct {
+	
+	PID source;
+	unsigned int size;
+	
+} MAIL_SLOT;
+
+#define MAIL_SLOT_HEADER		((sizeof(MAIL_SLOT) + KMALLOC_ALIGN - 1) / KMALLOC_ALIGN * KMALLOC_ALIGN)
+
+
 typedef struct {
 
 	MAILBOX id;
 	unsigned int capacity;
-	Queue mails;
-	Queue send_queue;	
-	Queue recv_queue;
+	MAIL_BUFFER *mail_head;					//Unread mails, oldest first
+	MAIL_BUFFER *mail_tail;
+	unsigned int mail_count;
+	
+	/*A ring mailbox copies mails into slots it allocated when it was created, instead of allocating each mail*/
+	unsigned char *ring;					//NULL if the mailbox isn't a ring mailbox
+	size_t slot_size;						//Largest message a slot holds
+	size_t slot_stride;						//Bytes from one slot to the next, including its header
+	unsigned int ring_head;					//Slot of the oldest unread mail
+	WaitQueue send_queue;	
+	WaitQueue recv_queue;
 	
 } MAILBOX_TYPE;
 
 
-/*Shared variables*/
-extern volatile unsigned int Last_MailboxID;
-
-
-
 void Mailbox_Reset(void);
 MAILBOX_TYPE* findMailboxByID(MAILBOX mb);
 
 void Kernel_Create_Mailbox(void);
-MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity);
+MAILBOX Kernel_Create_Mailbox_Direct(unsigned int capacity, size_t slot_size);
 void Kernel_Destroy_Mailbox(void);
 void Kernel_Mailbox_Destroy_Mail(void);
+void Kernel_Mailbox_Alloc_Buffer(void);
+void Kernel_Mailbox_Free_Buffer(void);
 
 void Kernel_Mailbox_Check(void);
 void Kernel_Mailbox_Send(void);
@@ -1,10 +1,14 @@
 #include "mutex.h"
 #include <string.h>
-#include <stdlib.h>		//Remove once kmalloc is used
 
-volatile static PtrList MutexList;				//Contains all the mutex objects
+#if MAXMUTEX > HANDLE_MAX_SLOTS
+#error "MAXMUTEX is larger than a handle table can hold"
+#endif
+
+static MUTEX_TYPE Mutex_Pool[MAXMUTEX];
+static HandleSlot Mutex_Slots[MAXMUTEX];
+static HandleTable MutexTable;					//Maps MUTEX IDs to the mutex objects
 volatile unsigned int Mutex_Count;				//Number of Mutexes created so far.
-volatile unsigned int Last_MutexID;				//Last (also highest) MUTEX value created so far.
 
 /************************************************************************/
 /*						USED DURING BOOTING                             */
@@ -13,10 +17,7 @@ volatile unsigned int Last_MutexID;				//Last (also highest) MUTEX value created
 void Mutex_Reset()
 {
 	Mutex_Count = 0;
-	Last_MutexID = 0;
-	
-	MutexList.ptr = NULL;
-	MutexList.next = NULL;
+	handle_table_init(&MutexTable, Mutex_Slots, Mutex_Pool, sizeof(MUTEX_TYPE), MAXMUTEX);
 }
 
 /************************************************************************/
@@ -25,8 +26,7 @@ void Mutex_Reset()
 
 MUTEX_TYPE* findMutexByMutexID(MUTEX m)
 {
-	PtrList *i;
-	MUTEX_TYPE *mutex_i;
+	MUTEX_TYPE *mut;
 	
 	//Ensure the request mutex ID is > 0
 	if(m <= 0)
@@ -38,15 +38,11 @@ MUTEX_TYPE* findMutexByMutexID(MUTEX m)
 		return NULL;
 	}
 	
-	for(i = &MutexList; i; i = i->next)
-	{
-		mutex_i = (MUTEX_TYPE*)i->ptr;
-		if (mutex_i->id == m)
-			return mutex_i;
-	}
+	mut = handle_lookup(&MutexTable, m);
+	if(!mut)
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
 	
-	kernel_raise_error(OBJECT_NOT_FOUND_ERR);
-	return NULL;
+	return mut;
 }
 
 
@@ -54,11 +50,10 @@ MUTEX_TYPE* findMutexByMutexID(MUTEX m)
 /*							MUTEX Creation 			                    */
 /************************************************************************/
 
-//We don't need a Kernel_Create_Mutex_Direct function, since no arguments are needed to create a new mutex object
-
-MUTEX Kernel_Create_Mutex(void)
+MUTEX Kernel_Create_Mutex_Direct(void)
 {
 	MUTEX_TYPE *mut;
+	MUTEX id;
 	
 	//Make sure the system's mutexes are not at max
 	if(Mutex_Count >= MAXMUTEX)
@@ -68,48 +63,37 @@ MUTEX Kernel_Create_Mutex(void)
 		#endif
 		
 		kernel_raise_error(MAX_OBJECT_ERR);
-		if(KernelActive)
-			Current_Process->request_retval = 0;
 		return 0;
 	}
 	
-	//Create a new Mutex object
-	mut = malloc(sizeof(MUTEX_TYPE));
-	ptrlist_add(&MutexList, mut);
+	//Take a free Mutex object from the pool
+	mut = handle_alloc(&MutexTable, &id);
 	++Mutex_Count; 
 	
-	mut->id = ++Last_MutexID;
+	mut->id = id;
 	mut->owner = 0;		
 	mut->lock_count = 0;
 	mut->highest_priority = LOWEST_PRIORITY;
-	mut->wait_queue = new_ptr_queue();
-	mut->orig_priority = new_int_queue();
+	Kernel_Wait_Queue_Init(&mut->wait_queue);
 	
 	#ifdef DEBUG
-	printf("Kernel_Create_Mutex: Created Mutex %d!\n", Last_MutexID);
+	printf("Kernel_Create_Mutex: Created Mutex %d!\n", mut->id);
 	#endif
 	
-	
-	if(KernelActive)
-		Current_Process->request_retval = mut->id;
 	return mut->id;
 }
 
+void Kernel_Create_Mutex(void)
+{
+	Syscall_Return(Current_Process, Kernel_Create_Mutex_Direct());
+}
+
 
 void Kernel_Destroy_Mutex(void)
 {
-	#define req_mut_id		Current_Process->request_args[0].val
+	#define req_mut_id		Syscall_Arg_Val(Current_Process, 0)
 	
-	PtrList *i;
-	MUTEX_TYPE *mut;
-	
-	//Find the corresponding Semaphore object in the semaphore list
-	for(i = &MutexList; i; i = i->next)
-	{
-		mut = (MUTEX_TYPE*)i->ptr;
-		if (mut->id == req_mut_id)
-			break;
-	}
+	MUTEX_TYPE *mut = findMutexByMutexID(req_mut_id);
 
 	if(!mut)
 	{
@@ -122,8 +106,8 @@ void Kernel_Destroy_Mutex(void)
 	
 	/*Should we check and make sure the wait queue is empty first?*/
 	
-	free(mut);
-	ptrlist_remove(&MutexList, i);
+	Kernel_Wait_Queue_Detach(&mut->wait_queue);
+	handle_free(&MutexTable, mut->id);
 	--Mutex_Count;
 	
 	
@@ -139,7 +123,7 @@ void Kernel_Destroy_Mutex(void)
 
 void Kernel_Lock_Mutex(void)
 {
-	#define req_mut_id		Current_Process->request_args[0].val
+	#define req_mut_id		Syscall_Arg_Val(Current_Process, 0)
 	
 	MUTEX_TYPE *m = findMutexByMutexID(req_mut_id);
 	
@@ -169,8 +153,8 @@ void Kernel_Lock_Mutex(void)
 	}
 		
 	//If I'm not the owner (mutex already locked): Add the current process to the wait queue
-	enqueue_ptr(&m->wait_queue, Current_Process);
-	enqueue_int(&m->orig_priority, Current_Process->pri);
+	Current_Process->wait_orig_pri = Current_Process->pri;
+	Kernel_Wait_Enqueue(&m->wait_queue, (PD*)Current_Process);
 	
 	//Inherit the highest priority if mine's not the highest
 	if(m->highest_priority < Current_Process->pri)
@@ -191,11 +175,11 @@ void Kernel_Lock_Mutex(void)
 
 static void Kernel_Lock_Mutex_From_Queue(MUTEX_TYPE *m)
 {
-	PD *p = dequeue_ptr(&m->wait_queue);
+	PD *p = Kernel_Wait_Dequeue(&m->wait_queue);
 	
 	//Pass the mutex to the head of the wait queue and lock it
 	m->owner = p->pid;
-	m->owner_orig_priority = dequeue_int(&m->orig_priority);
+	m->owner_orig_priority = p->wait_orig_pri;
 	m->lock_count++;
 
 	//Wake up the new mutex owner from its waiting state		
@@ -205,11 +189,11 @@ static void Kernel_Lock_Mutex_From_Queue(MUTEX_TYPE *m)
 		return;
 	}
 	
-	p->state = READY;
 	p->pri = m->highest_priority;		//Inherit the highest priority when entering the task's critical section
+	Kernel_Ready_Task(p);
 	
 	//Tell the kernel to switch to another task if there are others waiting on this mutex
-	Current_Process->state = READY;
+	Kernel_Ready_Task((PD*)Current_Process);
 	Kernel_Request_Cswitch = 1;
 }
 
@@ -217,7 +201,7 @@ static void Kernel_Lock_Mutex_From_Queue(MUTEX_TYPE *m)
 
 void Kernel_Unlock_Mutex(void)
 {
-	#define req_mut_id		Current_Process->request_args[0].val
+	#define req_mut_id		Syscall_Arg_Val(Current_Process, 0)
 	
 	MUTEX_TYPE* m = findMutexByMutexID(req_mut_id);
 	
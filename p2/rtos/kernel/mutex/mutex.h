@@ -2,7 +2,7 @@
 #define MUTEX_H_
 
 #include "../kernel_shared.h"
-#include "../others/Queue.h"
+#include "../hardware/cpuarch.h"
 
 
 #define MAXMUTEX					8
@@ -16,20 +16,19 @@ typedef struct {
 	unsigned int lock_count;				//mutex can be recursively locked
 	unsigned int highest_priority;
 	PRIORITY owner_orig_priority;
-	Queue wait_queue;
-	Queue orig_priority;
+	WaitQueue wait_queue;					//Each waiter keeps the priority it had before inheriting in its PD
 	
 } MUTEX_TYPE;
 
 
 /*Variables Accessible by the OS*/
 extern volatile unsigned int Mutex_Count;		//Number of Mutexes created so far.
-extern volatile unsigned int Last_MutexID;
 
 
 /*Accessible by OS*/
 MUTEX_TYPE* findMutexByMutexID(MUTEX m);
-MUTEX Kernel_Create_Mutex(void);
+MUTEX Kernel_Create_Mutex_Direct(void);
+void Kernel_Create_Mutex(void);
 void Kernel_Destroy_Mutex(void);
 
 
@@ -0,0 +1,85 @@
+/*
+A table of kernel objects indexed by their IDs. See HandleTable.h for how IDs are made up
+*/
+
+#include "HandleTable.h"
+
+
+
+//pool must hold capacity objects of obj_size bytes each
+void handle_table_init(HandleTable *t, HandleSlot *slots, void* pool, size_t obj_size, unsigned char capacity)
+{
+	unsigned char i;
+	
+	t->slots = slots;
+	t->pool = pool;
+	t->obj_size = obj_size;
+	t->capacity = capacity;
+	t->free_head = 0;
+	t->live_head = HANDLE_NO_SLOT;
+	t->live_tail = HANDLE_NO_SLOT;
+	
+	//Every slot starts out free, and they're handed out in order
+	for(i=0; i<capacity; i++)
+	{
+		slots[i].obj = NULL;
+		slots[i].generation = 0;
+		slots[i].next = i + 1;
+	}
+}
+
+//Takes a free object from the pool, and stores its new ID in id. Returns NULL if every object is in use
+void* handle_alloc(HandleTable *t, unsigned int *id)
+{
+	unsigned char slot = t->free_head;
+	HandleSlot *s;
+	
+	if(slot >= t->capacity)
+		return NULL;
+	
+	s = &t->slots[slot];
+	t->free_head = s->next;
+	
+	//Append the slot to the live list
+	s->next = HANDLE_NO_SLOT;
+	s->prev = t->live_tail;
+	if(t->live_tail != HANDLE_NO_SLOT)
+		t->slots[t->live_tail].next = slot;
+	else
+		t->live_head = slot;
+	t->live_tail = slot;
+	
+	s->obj = t->pool + slot * t->obj_size;
+	*id = s->generation | (slot + 1);
+	
+	return s->obj;
+}
+
+//Returns the object with the given ID to the pool. Its slot's generation is advanced, so the ID is never found again
+void handle_free(HandleTable *t, unsigned int id)
+{
+	unsigned char slot;
+	HandleSlot *s;
+	
+	if(!handle_lookup(t, id))
+		return;
+	
+	slot = (id & HANDLE_SLOT_MASK) - 1;
+	s = &t->slots[slot];
+	s->obj = NULL;
+	s->generation += (1 << HANDLE_SLOT_BITS);
+	
+	//Unlink the slot from the live list
+	if(s->prev != HANDLE_NO_SLOT)
+		t->slots[s->prev].next = s->next;
+	else
+		t->live_head = s->next;
+	
+	if(s->next != HANDLE_NO_SLOT)
+		t->slots[s->next].prev = s->prev;
+	else
+		t->live_tail = s->prev;
+	
+	s->next = t->free_head;
+	t->free_head = slot;
+}
@@ -0,0 +1,68 @@
+#ifndef HANDLETABLE_H_
+#define HANDLETABLE_H_
+
+#include "../../os.h"
+
+
+/*
+ * Maps the IDs of kernel objects (PIDs, MUTEX, SEMAPHORE, ...) to the objects themselves.
+ * The low HANDLE_SLOT_BITS of an ID are the object's slot in the table plus 1, so no valid ID is 0. The remaining bits are the
+ * slot's generation, which changes every time the slot is freed. An ID that outlived its object therefore never matches again.
+ *
+ * Each slot owns one object in a statically allocated pool, so creating a kernel object never needs malloc.
+ * Free slots are kept in a list, so both allocating and freeing an object take constant time.
+ * Slots in use are linked into a doubly linked live list with a tail, so iterating only visits objects that exist, and
+ * adding, removing and stepping to the next object (wrapping around) are constant time as well.
+ */
+#define HANDLE_SLOT_BITS		5
+#define HANDLE_SLOT_MASK		((1 << HANDLE_SLOT_BITS) - 1)
+#define HANDLE_MAX_SLOTS		HANDLE_SLOT_MASK				//Most slots a table can have
+#define HANDLE_NO_SLOT			0xFF							//End of the live list
+
+
+typedef struct {
+	void* obj;								//NULL if the slot is free
+	unsigned int generation;				//Generation bits of the slot's current ID. The slot bits are always 0
+	unsigned char next;						//Next slot in the free list while this slot is free, or in the live list while it's in use
+	unsigned char prev;						//Previous slot in the live list. Unused while the slot is free
+} HandleSlot;
+
+typedef struct {
+	HandleSlot *slots;
+	unsigned char *pool;					//Objects handed out by the table, one per slot
+	size_t obj_size;
+	unsigned char capacity;
+	unsigned char free_head;				//First free slot. Equal to capacity if every slot is in use
+	unsigned char live_head;				//First and last slot in use, in the order they were allocated. HANDLE_NO_SLOT if none are
+	unsigned char live_tail;
+} HandleTable;
+
+
+void handle_table_init(HandleTable *t, HandleSlot *slots, void* pool, size_t obj_size, unsigned char capacity);
+void* handle_alloc(HandleTable *t, unsigned int *id);
+void handle_free(HandleTable *t, unsigned int id);
+
+
+//Returns the object with the given ID, or NULL if the ID is invalid or stale. Inlined, since nearly every kernel request does this
+static inline void* handle_lookup(HandleTable *t, unsigned int id)
+{
+	unsigned int slot = (id & HANDLE_SLOT_MASK) - 1;		//Wraps around for ID 0
+	
+	if(slot >= t->capacity || t->slots[slot].generation != (id & ~HANDLE_SLOT_MASK))
+		return NULL;
+	
+	return t->slots[slot].obj;
+}
+
+//Object in the table's i-th slot. NULL if the slot is free
+#define handle_slot_obj(t, i)	((t)->slots[i].obj)
+
+//Iterates over the slots in use: for(i = handle_first(t); i != HANDLE_NO_SLOT; i = handle_next(t, i))
+#define handle_first(t)			((t)->live_head)
+#define handle_next(t, i)		((t)->slots[i].next)
+
+//Circular next. Wraps from the last slot in use back to the first
+#define handle_cnext(t, i)		(handle_next(t, i) == HANDLE_NO_SLOT ? handle_first(t) : handle_next(t, i))
+
+
+#endif /* HANDLETABLE_H_ */
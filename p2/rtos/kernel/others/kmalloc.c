@@ -4,6 +4,9 @@ Adding an offset to a memory address will make it go down (shrinking), and subtr
 
 This implementation of malloc saves heap space by minimizing the segment header (only stores segment size and next pointer), at the cost of runtime (no previous pointer).
 
+Requests up to KMALLOC_SMALL_MAX bytes are rounded up to a size class, and freed blocks of each class are kept on their own list instead of the address-sorted freelist.
+Small kernel objects are created and destroyed constantly, so they are recycled in O(1) without walking the freelist. They are never merged back into the freelist.
+
 For an annotated version of this file, please visit https://github.com/binexec/DynMemAllocator
 */
 
@@ -18,6 +21,10 @@ static uchar* kmalloc_heap_end;							//Absolute end of the memory segment for t
 static uchar* kmalloc_break;							//Also referred as "brk", the current end for the allocated heap	
 static Heap_Seg *freelist_head;							//Head of the first heap free list entry
 
+#if KMALLOC_SIZE_CLASSES > 0
+static Heap_Seg *class_head[KMALLOC_SIZE_CLASSES];		//Freed small blocks of each size class. Not sorted, and never merged
+#endif
+
 
 
 /************************************************************************/
@@ -28,6 +35,11 @@ static Heap_Seg *freelist_head;							//Head of the first heap free list entry
 
 #define segment_end(p)	((uchar*)p + sizeof(Heap_Seg) + p->size)
 
+#define round_up(len, n)	(((len) + (n) - 1) / (n) * (n))
+
+//Index of the size class a small request falls into
+#define size_class(len)		(((len) - 1) / KMALLOC_CLASS_SIZE)
+
 
 static int check_stack_integrity(void* new_break)
 {
@@ -59,6 +71,13 @@ static int pointer_is_valid(void* p)
 }
 
 
+//Returns 1 if p points into the allocated part of the heap, so reading a header in front of it is safe. It doesn't prove p came from kmalloc
+int kmalloc_in_heap(void *p)
+{
+	return (uchar*)p >= kmalloc_break + sizeof(Heap_Seg) && (uchar*)p <= kmalloc_heap_start;
+}
+
+
 static inline void write_seg_header(void* seg_header, size_t len, Heap_Seg* next)
 {
 	Heap_Seg* new_entry =  (Heap_Seg*)seg_header;
@@ -96,18 +115,29 @@ void* get_kmalloc_break()
 
 int init_kmalloc(uchar* start, uchar* end)
 {
+	#if KMALLOC_SIZE_CLASSES > 0
+	int i;
+	#endif
+	
 	if(start < end)
 	{
 		printf("Heap starting address must be greater than end address!\n");
 		return 0;
 	}
 	
+	//Blocks are carved downwards from the start, so aligning the start keeps every block aligned
+	start = (uchar*)((uintptr_t)start / KMALLOC_ALIGN * KMALLOC_ALIGN);
+	
 	kmalloc_heap_start 	= start;
 	kmalloc_heap_end 	= end;
 	kmalloc_break 		= kmalloc_heap_start;	
 	freelist_head 		= NULL;
 	
-	printf("Heap Start: %p, Heap End: %p\n\n", kmalloc_heap_start, kmalloc_heap_end);
+	#if KMALLOC_SIZE_CLASSES > 0
+	for(i=0; i<KMALLOC_SIZE_CLASSES; i++)
+		class_head[i] = NULL;
+	#endif
+	
 	return 1;
 }
 
@@ -121,6 +151,10 @@ kMalloc_Param save_kmalloc_param(void)
 	p.kmalloc_break 			= kmalloc_break;
 	p.freelist_head 		= freelist_head;
 	
+	#if KMALLOC_SIZE_CLASSES > 0
+	memcpy(p.class_head, class_head, sizeof(class_head));
+	#endif
+	
 	return p;
 }
 
@@ -131,6 +165,10 @@ void load_kmalloc_param(kMalloc_Param p)
 	kmalloc_heap_end 	= p.kmalloc_heap_end;
 	kmalloc_break 		= p.kmalloc_break;
 	freelist_head 		= p.freelist_head;
+	
+	#if KMALLOC_SIZE_CLASSES > 0
+	memcpy(class_head, p.class_head, sizeof(class_head));
+	#endif
 }
 
 
@@ -147,9 +185,9 @@ void load_kmalloc_param(kMalloc_Param p)
 /*								MALLOC		  							*/
 /************************************************************************/
 
-void* kmalloc(size_t len)
+//Takes a piece of exactly len bytes from the freelist or the unallocated heap. len must be a multiple of KMALLOC_ALIGN
+static void* kmalloc_bestfit(size_t len)
 {
-	
 	Heap_Seg *current_piece = NULL, *previous_piece = NULL;
 	Heap_Seg *exact_piece = NULL, *exact_piece_prev = NULL;
 	Heap_Seg *next_smallest_piece = NULL;
@@ -159,7 +197,7 @@ void* kmalloc(size_t len)
 
 	/*Attempt 1: Find an exact piece*/
 	
-	for(current_piece = freelist_head; current_piece; current_piece = current_piece->next, previous_piece = current_piece)
+	for(current_piece = freelist_head; current_piece; previous_piece = current_piece, current_piece = current_piece->next)
 	{
 		if(current_piece->size == len)
 		{
@@ -217,6 +255,38 @@ void* kmalloc(size_t len)
 }
 
 
+void* kmalloc(size_t len)
+{
+	#if KMALLOC_SIZE_CLASSES > 0
+	Heap_Seg *seg;
+	#endif
+	
+	if(len == 0)
+		return NULL;
+	
+	/*Small requests are served from the free list of their size class first*/
+	
+	if(len <= KMALLOC_SMALL_MAX)
+	{
+		len = round_up(len, KMALLOC_CLASS_SIZE);
+		
+		#if KMALLOC_SIZE_CLASSES > 0
+		seg = class_head[size_class(len)];
+		if(seg)
+		{
+			class_head[size_class(len)] = seg->next;
+			seg->next = NULL;
+			return (uchar*)seg + sizeof(Heap_Seg);
+		}
+		#endif
+	}
+	else
+		len = round_up(len, KMALLOC_ALIGN);
+	
+	return kmalloc_bestfit(len);
+}
+
+
 
 
 
@@ -268,6 +338,18 @@ void kfree(void *p)
 		return;
 	
 	
+	/*Small blocks go back to the free list of their size class*/
+	
+	#if KMALLOC_SIZE_CLASSES > 0
+	if(p_entry->size <= KMALLOC_SMALL_MAX)
+	{
+		p_entry->next = class_head[size_class(p_entry->size)];
+		class_head[size_class(p_entry->size)] = p_entry;
+		return;
+	}
+	#endif
+	
+	
 	/*Step 1: Freeing the requested piece*/
 	
 	for(current_piece = freelist_head; current_piece; current_piece = current_piece->next)
@@ -361,6 +443,21 @@ void kfree(void *p)
 /*								REALLOC		  							*/
 /************************************************************************/
 
+//Copies p into a new allocation of len bytes, and frees p
+static void* krealloc_move(void *p, size_t len)
+{
+	Heap_Seg *p_entry = p - sizeof(Heap_Seg);
+	uchar* retaddr = kmalloc(len);
+	
+	if(!retaddr) 
+		return NULL;
+	memcpy(retaddr, p, len < p_entry->size ? len : p_entry->size);
+	kfree(p);
+
+	return retaddr;
+}
+
+
 void* krealloc(void *p, size_t len)
 {
 	Heap_Seg *p_entry = p - sizeof(Heap_Seg);
@@ -376,6 +473,12 @@ void* krealloc(void *p, size_t len)
 	if(!pointer_is_valid(p))
 		return NULL;
 	
+	//Small blocks must keep the size of their class, so they are always moved
+	if(len <= KMALLOC_SMALL_MAX || p_entry->size <= KMALLOC_SMALL_MAX)
+		return krealloc_move(p, len);
+	
+	len = round_up(len, KMALLOC_ALIGN);
+	
 	/*Shrinking*/
 	
 	size_diff = len - p_entry->size;
@@ -387,7 +490,8 @@ void* krealloc(void *p, size_t len)
 	{
 		size_diff = p_entry->size - len;		//Make size_diff positive
 		
-		if(size_diff <= sizeof(Heap_Seg))
+		//The trimmed piece is freed, so it must be too big for a size class
+		if(size_diff <= sizeof(Heap_Seg) + KMALLOC_SMALL_MAX)
 			return p;
 
 		retaddr = (uchar*)p + size_diff;
@@ -446,18 +550,14 @@ void* krealloc(void *p, size_t len)
 	
 	/*New Allocation for growth*/
 	
-	retaddr = kmalloc(len);
-	if(!retaddr) 
-		return NULL;
-	memcpy(p, retaddr, p_entry->size);
-	kfree(p);
-
-	return retaddr;
+	return krealloc_move(p, len);
 }
 
 
 #undef MAX_HEAP_SIZE
 #undef segment_end
+#undef round_up
+#undef size_class
 
 
 
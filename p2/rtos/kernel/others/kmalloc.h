@@ -10,6 +10,16 @@
 #endif
 
 
+#define KMALLOC_ALIGN			sizeof(void*)			//Every block is a multiple of this, so pointers stored in blocks stay aligned
+#define KMALLOC_CLASS_SIZE		(2*sizeof(void*))		//Size classes are multiples of this. The smallest class fits a small list node
+
+#ifndef KMALLOC_SIZE_CLASSES
+#define KMALLOC_SIZE_CLASSES	4						//Number of small size classes with their own free list. 0 uses best-fit for everything
+#endif
+
+#define KMALLOC_SMALL_MAX		(KMALLOC_SIZE_CLASSES * KMALLOC_CLASS_SIZE)
+
+
 /*
 *	Represents a piece of free memory on the heap, forming a chain of freelist. 
 *	This data structure is also used to mark an allocated piece of memory within the heap, 
@@ -30,6 +40,10 @@ typedef struct {
 	unsigned char* kmalloc_break;
 	Heap_Seg *freelist_head;
 	
+	#if KMALLOC_SIZE_CLASSES > 0
+	Heap_Seg *class_head[KMALLOC_SIZE_CLASSES];
+	#endif
+	
 }kMalloc_Param;
 
 
@@ -42,6 +56,7 @@ void* kmalloc(size_t len);
 void* kcalloc(size_t nitems, size_t size);
 void kfree(void *p);
 void* krealloc(void *ptr, size_t len);
+int kmalloc_in_heap(void *p);
 
 
 #endif /* KMALLOC_H */
\ No newline at end of file
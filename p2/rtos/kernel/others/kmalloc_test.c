@@ -0,0 +1,77 @@
+/*
+Allocator benchmark for the host. See the "bench" target in host/Makefile, which builds this file twice:
+once with the size classes from kmalloc.h, and once with KMALLOC_SIZE_CLASSES=0 so every request takes the best-fit path.
+*/
+
+#include "kmalloc.h"
+#include <time.h>
+
+#define HEAP_SIZE		32768
+#define LONG_LIVED		128					//Message copies that stay allocated while the small objects come and go
+#define SMALL_OBJECTS	32					//Small objects allocated and freed in each round
+#define ROUNDS			20000
+
+#define NODE_SIZE		(2*sizeof(void*))	//A small list node: a pointer and a link
+#define MAIL_SIZE		(sizeof(void*) + 3*sizeof(int) + 8)	//A MAIL_BUFFER: its header and a short message
+
+static unsigned char heap[HEAP_SIZE];
+
+
+static unsigned long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+
+//Leaves the heap fragmented the way a mailbox does, with freed message copies between the ones still waiting to be read
+static int fragment_heap(void)
+{
+	void *blocks[LONG_LIVED];
+	unsigned int seed = 1;
+	int i, freed = 0;
+
+	for(i=0; i<LONG_LIVED; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		blocks[i] = kmalloc(80 + (seed >> 16) % 96);
+	}
+
+	for(i=0; i<LONG_LIVED; i+=2)
+	{
+		kfree(blocks[i]);
+		++freed;
+	}
+
+	return freed;
+}
+
+
+int main()
+{
+	void *small[SMALL_OBJECTS];
+	unsigned long start, elapsed;
+	int i, j, free_pieces;
+
+	init_kmalloc(heap + HEAP_SIZE, heap);
+	free_pieces = fragment_heap();
+
+	start = now_ns();
+	for(i=0; i<ROUNDS; i++)
+	{
+		for(j=0; j<SMALL_OBJECTS; j++)
+			small[j] = kmalloc(j & 1 ? MAIL_SIZE : NODE_SIZE);
+
+		//Queues release their elements in FIFO order
+		for(j=0; j<SMALL_OBJECTS; j++)
+			kfree(small[j]);
+	}
+	elapsed = now_ns() - start;
+
+	printf("Size classes: %d\t Free pieces: %d\t Avg ns per kmalloc+kfree: %lu.%02lu\n", KMALLOC_SIZE_CLASSES, free_pieces,
+		elapsed / (ROUNDS*SMALL_OBJECTS), elapsed * 100 / (ROUNDS*SMALL_OBJECTS) % 100);
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+#include "isr_queue.h"
+
+
+#if MAXISRQUEUE > HANDLE_MAX_SLOTS
+#error "MAXISRQUEUE is larger than a handle table can hold"
+#endif
+
+static ISR_QUEUE_TYPE ISR_Queue_Pool[MAXISRQUEUE];
+static HandleSlot ISR_Queue_Slots[MAXISRQUEUE];
+static HandleTable ISRQueueTable;				//Maps ISR_QUEUE IDs to the queue objects
+volatile unsigned int ISR_Queue_Count;
+volatile PRIORITY ISR_Queue_Wake_Pri;
+
+#define Queue_Item(queue, index)		((queue)->items + ((index) & (queue)->mask) * (queue)->item_size)
+
+
+void ISR_Queue_Reset(void)
+{
+	ISR_Queue_Count = 0;
+	ISR_Queue_Wake_Pri = LOWEST_PRIORITY + 1;
+	handle_table_init(&ISRQueueTable, ISR_Queue_Slots, ISR_Queue_Pool, sizeof(ISR_QUEUE_TYPE), MAXISRQUEUE);
+}
+
+ISR_QUEUE_TYPE* findISRQueueByID(ISR_QUEUE q)
+{
+	//Returns NULL if the queue is not found
+	return handle_lookup(&ISRQueueTable, q);
+}
+
+
+/************************************************************************/
+/*						ISR Queue Creation                              */
+/************************************************************************/
+
+ISR_QUEUE Kernel_Create_ISR_Queue_Direct(unsigned int capacity, size_t item_size)
+{
+	ISR_QUEUE_TYPE *queue;
+	ISR_QUEUE id;
+	unsigned char *items;
+
+	if(ISR_Queue_Count >= MAXISRQUEUE)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Create_ISR_Queue: Failed to create ISR Queue. The system is at its max ISR queue threshold.\n");
+		#endif
+
+		kernel_raise_error(MAX_OBJECT_ERR);
+		return 0;
+	}
+
+	//A power of two capacity lets the free running indices be masked into the ring, instead of wrapped with a division
+	if(capacity == 0 || capacity > ISR_QUEUE_MAX_CAPACITY || (capacity & (capacity - 1)) || item_size == 0)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Create_ISR_Queue: Failed to create ISR Queue. The capacity must be a power of two up to %d.\n", ISR_QUEUE_MAX_CAPACITY);
+		#endif
+
+		kernel_raise_error(INVALID_ARG_ERR);
+		return 0;
+	}
+
+	items = kmalloc(capacity * item_size);
+	if(!items)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Create_ISR_Queue: Failed to create ISR Queue. No room for %d items of %d bytes.\n", capacity, (int)item_size);
+		#endif
+
+		kernel_raise_error(MALLOC_FAILED_ERR);
+		return 0;
+	}
+
+	//Take a free ISR Queue object from the pool
+	queue = handle_alloc(&ISRQueueTable, &id);
+	++ISR_Queue_Count;
+
+	queue->id = id;
+	queue->head = 0;
+	queue->tail = 0;
+	queue->mask = capacity - 1;
+	queue->item_size = item_size;
+	queue->items = items;
+	Kernel_Wait_Queue_Init(&queue->wait_queue);
+
+	return queue->id;
+}
+
+void Kernel_Create_ISR_Queue(void)
+{
+	#define req_capacity		Syscall_Arg_Val(Current_Process, 0)
+	#define req_item_size		Syscall_Arg(Current_Process, 1)
+
+	Syscall_Return(Current_Process, Kernel_Create_ISR_Queue_Direct(req_capacity, req_item_size));
+
+	#undef req_capacity
+	#undef req_item_size
+}
+
+
+//The ISR must not push to the queue anymore once it's destroyed
+void Kernel_Destroy_ISR_Queue(void)
+{
+	#define req_queue_id		Syscall_Arg_Val(Current_Process, 0)
+
+	ISR_QUEUE_TYPE *queue = findISRQueueByID(req_queue_id);
+
+	if(!queue)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Destroy_ISR_Queue: The requested ISR Queue %d was not found!\n", req_queue_id);
+		#endif
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
+		return;
+	}
+
+	Kernel_Wait_Queue_Detach(&queue->wait_queue);
+	kfree(queue->items);
+	handle_free(&ISRQueueTable, queue->id);
+	--ISR_Queue_Count;
+
+	#undef req_queue_id
+}
+
+
+/************************************************************************/
+/*				Pushing and Popping (outside of the kernel)             */
+/************************************************************************/
+
+//Called by the producing ISR, with interrupts disabled. Returns 0 if the queue is full, and the item is dropped
+int Kernel_ISR_Queue_Push(ISR_QUEUE q, const void *item)
+{
+	ISR_QUEUE_TYPE *queue = findISRQueueByID(q);
+	unsigned char tail;
+	PD *waiter;
+
+	if(!queue)
+		return 0;
+
+	tail = queue->tail;
+	if((unsigned char)(tail - queue->head) > queue->mask)
+		return 0;
+
+	memcpy(Queue_Item(queue, tail), item, queue->item_size);
+	Compiler_Barrier();							//The item has to be in its slot before the consumer can see it
+	queue->tail = tail + 1;
+
+	//The wait queue is only changed by the kernel, which never runs while an ISR does. The kernel wakes the consumer later
+	waiter = queue->wait_queue.head;
+	if(waiter && waiter->pri < ISR_Queue_Wake_Pri)
+		ISR_Queue_Wake_Pri = waiter->pri;
+
+	return 1;
+}
+
+//Called by the consuming task. Returns 0 if the queue is empty
+int Kernel_ISR_Queue_Pop(ISR_QUEUE q, void *item)
+{
+	ISR_QUEUE_TYPE *queue = findISRQueueByID(q);
+	unsigned char head;
+
+	if(!queue)
+		return 0;
+
+	head = queue->head;
+	if(head == queue->tail)
+		return 0;
+
+	Compiler_Barrier();							//Don't read the slot before the tail that published it
+	memcpy(item, Queue_Item(queue, head), queue->item_size);
+	Compiler_Barrier();							//The item has to be copied out before its slot is handed back to the ISR
+	queue->head = head + 1;
+
+	return 1;
+}
+
+
+/************************************************************************/
+/*						Waiting for Items                               */
+/************************************************************************/
+
+//Blocks the consumer until the queue has an item. Returns 1 once it does, or 0 if the request timed out
+void Kernel_ISR_Queue_Wait(void)
+{
+	#define req_queue_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_timeout			Syscall_Arg_Val(Current_Process, 1)
+
+	ISR_QUEUE_TYPE *queue = findISRQueueByID(req_queue_id);
+
+	if(!queue)
+	{
+		#ifdef DEBUG
+		printf("Kernel_ISR_Queue_Wait: The requested ISR Queue %d was not found!\n", req_queue_id);
+		#endif
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
+		Syscall_Return(Current_Process, 0);
+		return;
+	}
+
+	Syscall_Return(Current_Process, 1);
+
+	//An item could have been pushed after the consumer found the queue empty, but before it entered the kernel
+	if(queue->head != queue->tail)
+		return;
+
+	Current_Process->request_timeout = req_timeout;
+	Kernel_Wait_Enqueue(&queue->wait_queue, (PD*)Current_Process);
+	Current_Process->state = WAIT_ISR_QUEUE;
+	Kernel_Request_Cswitch = 1;
+
+	#undef req_queue_id
+	#undef req_timeout
+}
+
+//Carries out the wake-ups ISRs have flagged since the last time. Called by the kernel before it picks the next task
+void Kernel_ISR_Queue_Wake(void)
+{
+	ISR_QUEUE_TYPE *queue;
+	unsigned char i;
+
+	if(ISR_Queue_Wake_Pri > LOWEST_PRIORITY)
+		return;
+
+	ISR_Queue_Wake_Pri = LOWEST_PRIORITY + 1;
+
+	for(i = handle_first(&ISRQueueTable); i != HANDLE_NO_SLOT; i = handle_next(&ISRQueueTable, i))
+	{
+		queue = handle_slot_obj(&ISRQueueTable, i);
+		if(queue->wait_queue.head && queue->head != queue->tail)
+			Kernel_Ready_Task(queue->wait_queue.head);			//Also takes it off the wait queue
+	}
+}
+
+
+#undef Queue_Item
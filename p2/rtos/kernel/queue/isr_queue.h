@@ -0,0 +1,44 @@
+#ifndef ISR_QUEUE_H_
+#define ISR_QUEUE_H_
+
+#include "../kernel_shared.h"
+#include "../hardware/cpuarch.h"
+
+#define MAXISRQUEUE					4
+#define ISR_QUEUE_MAX_CAPACITY		128				//The indices are free running bytes, so the count of items must fit in one
+
+
+/*
+ * Ring buffer written by one ISR and read by one task. Each side only ever writes its own index, and an index is a single byte,
+ * so neither side needs a lock and the ISR never enters the kernel. The ISR can't wake the consumer itself. It only flags the
+ * wake-up, which the kernel carries out the next time it dispatches a task, or at the next tick if the consumer outranks the running task.
+ */
+typedef struct {
+
+	ISR_QUEUE id;
+	volatile unsigned char head;			//Items popped so far. Only written by the consumer
+	volatile unsigned char tail;			//Items pushed so far. Only written by the ISR
+	unsigned char mask;						//capacity - 1. The capacity is a power of two
+	size_t item_size;
+	unsigned char *items;
+	WaitQueue wait_queue;					//Consumer blocked on the queue while it's empty
+
+} ISR_QUEUE_TYPE;
+
+
+/*Variables Accessible by the OS*/
+extern volatile unsigned int ISR_Queue_Count;
+extern volatile PRIORITY ISR_Queue_Wake_Pri;		//Highest priority of a consumer an ISR has flagged for wake-up. LOWEST_PRIORITY+1 if none were
+
+
+void ISR_Queue_Reset(void);
+ISR_QUEUE Kernel_Create_ISR_Queue_Direct(unsigned int capacity, size_t item_size);
+void Kernel_Create_ISR_Queue(void);
+void Kernel_Destroy_ISR_Queue(void);
+void Kernel_ISR_Queue_Wait(void);
+void Kernel_ISR_Queue_Wake(void);
+int Kernel_ISR_Queue_Push(ISR_QUEUE q, const void *item);
+int Kernel_ISR_Queue_Pop(ISR_QUEUE q, void *item);
+
+
+#endif /* ISR_QUEUE_H_ */
@@ -1,19 +1,20 @@
 #include "semaphore.h"
-#include <stdlib.h>		//Remove once kmalloc is used
 
 
-volatile static PtrList SemaphoreList;
+#if MAXSEMAPHORE > HANDLE_MAX_SLOTS
+#error "MAXSEMAPHORE is larger than a handle table can hold"
+#endif
+
+static SEMAPHORE_TYPE Semaphore_Pool[MAXSEMAPHORE];
+static HandleSlot Semaphore_Slots[MAXSEMAPHORE];
+static HandleTable SemaphoreTable;				//Maps SEMAPHORE IDs to the semaphore objects
 volatile unsigned int Semaphore_Count;		
-volatile unsigned int Last_SemaphoreID;
 
 
 void Semaphore_Reset(void)
 {
 	Semaphore_Count = 0;
-	Last_SemaphoreID = 0;
-	
-	SemaphoreList.ptr = NULL;
-	SemaphoreList.next = NULL;
+	handle_table_init(&SemaphoreTable, Semaphore_Slots, Semaphore_Pool, sizeof(SEMAPHORE_TYPE), MAXSEMAPHORE);
 }
 
 /************************************************************************/
@@ -21,18 +22,8 @@ void Semaphore_Reset(void)
 /************************************************************************/
 SEMAPHORE_TYPE* findSemaphoreByID(SEMAPHORE s)
 {
-	PtrList *i;
-	SEMAPHORE_TYPE *sem_i;
-	
-	for(i = &SemaphoreList; i; i = i->next)
-	{
-		sem_i = (SEMAPHORE_TYPE*)i->ptr;
-		if (sem_i->id == s)
-			return sem_i;
-	}
-	
-	//Semaphore not found
-	return NULL;
+	//Returns NULL if the semaphore is not found
+	return handle_lookup(&SemaphoreTable, s);
 }
 
 
@@ -44,6 +35,7 @@ SEMAPHORE_TYPE* findSemaphoreByID(SEMAPHORE s)
 SEMAPHORE Kernel_Create_Semaphore_Direct(int initial_count, unsigned int is_binary)
 {
 	SEMAPHORE_TYPE *sem;
+	SEMAPHORE id;
 	
 	//Ensure There are still free semaphores available
 	if (Semaphore_Count >= MAXSEMAPHORE)
@@ -56,13 +48,12 @@ SEMAPHORE Kernel_Create_Semaphore_Direct(int initial_count, unsigned int is_bina
 		return 0;
 	}
 	
-	//Create a new Semaphore object and add it to the semaphore list
-	sem = malloc(sizeof(SEMAPHORE_TYPE));
-	ptrlist_add(&SemaphoreList, sem);
+	//Take a free Semaphore object from the pool
+	sem = handle_alloc(&SemaphoreTable, &id);
 	++Semaphore_Count;
 
-	sem->id = ++Last_SemaphoreID;
-	sem->wait_queue = new_ptr_queue();
+	sem->id = id;
+	Kernel_Wait_Queue_Init(&sem->wait_queue);
 
 	//Creating a binary semaphore
 	if(is_binary > 0)
@@ -90,10 +81,10 @@ SEMAPHORE Kernel_Create_Semaphore_Direct(int initial_count, unsigned int is_bina
 
 void Kernel_Create_Semaphore()
 {
-	#define req_initial_count		Current_Process->request_args[0].val
-	#define req_is_binary			Current_Process->request_args[1].val
+	#define req_initial_count		Syscall_Arg_Val(Current_Process, 0)
+	#define req_is_binary			Syscall_Arg_Val(Current_Process, 1)
 	
-	Current_Process->request_retval = Kernel_Create_Semaphore_Direct(req_initial_count, req_is_binary);
+	Syscall_Return(Current_Process, Kernel_Create_Semaphore_Direct(req_initial_count, req_is_binary));
 	
 	#undef req_initial_count
 	#undef req_is_binary
@@ -102,18 +93,9 @@ void Kernel_Create_Semaphore()
 
 void Kernel_Destroy_Semaphore()
 {
-	#define req_sem_id		Current_Process->request_args[0].val
+	#define req_sem_id		Syscall_Arg_Val(Current_Process, 0)
 	
-	PtrList *i;
-	SEMAPHORE_TYPE *sem;	
-	
-	//Find the corresponding Semaphore object in the semaphore list
-	for(i = &SemaphoreList; i; i = i->next)
-	{
-		sem = (SEMAPHORE_TYPE*)i->ptr;
-		if (sem->id == req_sem_id)
-			break;
-	}
+	SEMAPHORE_TYPE *sem = findSemaphoreByID(req_sem_id);
 
 	if(!sem)
 	{
@@ -126,8 +108,8 @@ void Kernel_Destroy_Semaphore()
 	
 	/*Should we check and make sure the wait queue is empty first?*/
 	
-	free(sem);
-	ptrlist_remove(&SemaphoreList, i);
+	Kernel_Wait_Queue_Detach(&sem->wait_queue);
+	handle_free(&SemaphoreTable, sem->id);
 	--Semaphore_Count;
 	
 	
@@ -139,14 +121,30 @@ void Kernel_Destroy_Semaphore()
 /*						Semaphore Operations                            */
 /************************************************************************/
 
+//The amount a task asked for in its SEM_GET request. A binary semaphore never gives out more than 1 count at a time
+static inline int Semaphore_Req_Amount(SEMAPHORE_TYPE *sem, PD *p)
+{
+	int amount = Syscall_Arg_Val(p, 1);
+	
+	if(sem->is_binary)
+	{
+		if(amount > 1)
+			amount = 1;
+		else if(amount < 0)
+			amount = 0;
+	}
+	
+	return amount;
+}
+
 static inline void Kernel_Semaphore_Get_From_Queue(SEMAPHORE_TYPE *sem)
 {
-	#define head_req_amount		head->request_args[1].val
+	#define head_req_amount		Semaphore_Req_Amount(sem, head)
 	
-	PD *head = queue_peek_ptr(&sem->wait_queue);	
+	PD *head = sem->wait_queue.head;
 	
 	//See if the semaphore has enough counts to fulfill the amount wanted by the head(s) of the wait queue
-	while(sem->count - head_req_amount >= 0)
+	while(head && sem->count - head_req_amount >= 0)
 	{
 		if(head->state != WAIT_SEMAPHORE)
 		{
@@ -158,10 +156,9 @@ static inline void Kernel_Semaphore_Get_From_Queue(SEMAPHORE_TYPE *sem)
 		}
 		
 		sem->count -= head_req_amount;
-		head->state = READY;
+		Kernel_Ready_Task(head);			//Also takes it off the wait queue
 		
-		dequeue_int(&sem->wait_queue);
-		head = queue_peek_ptr(&sem->wait_queue);
+		head = sem->wait_queue.head;
 	}
 	
 	#undef head_req_amount
@@ -170,8 +167,8 @@ static inline void Kernel_Semaphore_Get_From_Queue(SEMAPHORE_TYPE *sem)
 
 void Kernel_Semaphore_Get()
 {
-	#define req_sem_id		Current_Process->request_args[0].val
-	#define req_amount		Current_Process->request_args[1].val
+	#define req_sem_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_amount		Semaphore_Req_Amount(sem, (PD*)Current_Process)
 	
 	SEMAPHORE_TYPE *sem = findSemaphoreByID(req_sem_id);
 	int has_enough;
@@ -185,22 +182,13 @@ void Kernel_Semaphore_Get()
 		return;
 	}
 	
-	//If it's a binary semaphore, do not allow more than 1 counts to be taken
-	if(sem->is_binary)
-	{
-		if(req_amount > 1)
-		req_amount = 1;
-		else if(req_amount < 0)
-		req_amount = 0;
-	}
-	
 	//Are there enough counts in the semaphore to handle this request?
 	has_enough = sem->count - req_amount;
 	
 	//If not, add the process to the semaphore's waiting queue, and put the task into the WAIT_SEMAPHORE state
 	if(has_enough < 0)
 	{
-		enqueue_ptr(&sem->wait_queue, Current_Process);
+		Kernel_Wait_Enqueue(&sem->wait_queue, (PD*)Current_Process);
 		Current_Process->state = WAIT_SEMAPHORE;
 		Kernel_Request_Cswitch = 1;
 		return;
@@ -215,8 +203,8 @@ void Kernel_Semaphore_Get()
 
 void Kernel_Semaphore_Give()
 {
-	#define req_sem_id		Current_Process->request_args[0].val
-	#define req_amount		Current_Process->request_args[1].val
+	#define req_sem_id		Syscall_Arg_Val(Current_Process, 0)
+	#define req_amount		Syscall_Arg_Val(Current_Process, 1)
 	
 	SEMAPHORE_TYPE *sem = findSemaphoreByID(req_sem_id);
 	
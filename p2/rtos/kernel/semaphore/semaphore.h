@@ -2,7 +2,7 @@
 #define SEMAPHORE_H_
 
 #include "../kernel_shared.h"
-#include "../others/Queue.h"
+#include "../hardware/cpuarch.h"
 
 
 #define MAXSEMAPHORE				8
@@ -13,14 +13,13 @@ typedef struct {
 	SEMAPHORE id;
 	int count;					
 	unsigned int is_binary;				//0 if it's a counting semaphore; 1 if it's a binary semaphore
-	Queue wait_queue;
+	WaitQueue wait_queue;
 
 } SEMAPHORE_TYPE;
 
 
 /*Variables Accessible by the OS*/
 extern volatile unsigned int Semaphore_Count;		//Number of Mutexes created so far.
-extern volatile unsigned int Last_SemaphoreID;
 
 
 void Kernel_Create_Semaphore(void);
@@ -1,19 +1,21 @@
 #include "task.h"
-#include <stdlib.h>		//Remove once kmalloc is used
 
 
-volatile PtrList ProcessList;					//Contains the process descriptor for all tasks, regardless of their current state.
+#if MAXTHREAD > HANDLE_MAX_SLOTS
+#error "MAXTHREAD is larger than a handle table can hold"
+#endif
+
+static PD Process_Pool[MAXTHREAD];
+static HandleSlot Process_Slots[MAXTHREAD];
+HandleTable ProcessTable;						//Maps PIDs to the process descriptor of every task, regardless of their current state.
 volatile unsigned int Task_Count;				//Number of tasks created so far.
-volatile unsigned int Last_PID;					//Last (also highest) PID value created so far.
 
 
 void Task_Reset()
 {
 	Task_Count = 0;
-	Last_PID = 0;
-
-	ProcessList.ptr = NULL;
-	ProcessList.next = NULL;
+	Workspace_Reset();
+	handle_table_init(&ProcessTable, Process_Slots, Process_Pool, sizeof(PD), MAXTHREAD);
 }
 
 
@@ -21,9 +23,10 @@ void Task_Reset()
 /*                   TASK RELATED KERNEL FUNCTIONS                      */
 /************************************************************************/
 
-PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg)
+PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK quantum)
 {
 	PD *p;
+	PID pid;
 	
 	//Make sure the system can still have enough resources to create more tasks
 	if (Task_Count == MAXTHREAD)
@@ -36,42 +39,83 @@ PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int
 		return 0;
 	}
 	
-	p = malloc(sizeof(PD));
-	if(!p)
+	//Each priority level has its own ready queue, so the priority must be within range
+	if (py > LOWEST_PRIORITY)
 	{
-		kernel_raise_error(MALLOC_FAILED_ERR);
+		#ifdef DEBUG
+		printf("Kernel_Create_Task: Failed to create task. Priority %d is out of range\n", py);
+		#endif
+		
+		kernel_raise_error(INVALID_ARG_ERR);
 		return 0;
 	}
-	ptrlist_add(&ProcessList, p);
+	
+	//Take a free process descriptor from the pool
+	p = handle_alloc(&ProcessTable, &pid);
 	++Task_Count;
 	
 
 	//Build the process descriptor for the new task
-	p->pid = ++Last_PID;
+	p->pid = pid;
 	p->pri = py;
-	p->stack_size = stack_size;
 	p->arg = arg;
-	p->request = NONE;
-	p->state = READY;
 	p->code = f;
+	p->ready_next = NULL;
+	p->ready_prev = NULL;
 	
-	#ifdef PREVENT_STARVATION
-	p->starvation_ticks = 0;
+	#ifdef PREEMPTIVE_CSWITCH
+	p->quantum = quantum;
+	p->slice_remaining = 0;					//The first slice is handed out when the task is dispatched
 	#endif
 	
+	#ifdef EDF_SCHEDULING
+	p->deadline = 0;
+	p->has_deadline = 0;					//Runs in FIFO order within the EDF band until it sets a deadline
+	#endif
+	
+	#ifdef PERIODIC_TASKS
+	p->period = 0;
+	p->next_release = 0;
+	p->max_jitter = 0;
+	p->overruns = 0;
+	p->job_released = 0;
+	#endif
+	
+	p->request_timeout = 0;
+	p->request_progress = 0;
+	p->timeout_next = NULL;
+	p->timeout_prev = NULL;
+	p->wait_queue = NULL;
+	p->wait_next = NULL;
+	p->wait_prev = NULL;
 	
-	//Initializing the workspace memory (stack and sp) for the new task
-	p->stack = malloc(stack_size);
+	
+	//Take a stack from the workspace. The task gets all of it, even if it asked for less
+	p->stack = Workspace_Alloc_Stack(&stack_size);
 	if(!p->stack)
 	{
+		#ifdef DEBUG
+		printf("Kernel_Create_Task: Failed to create task. No free stack can hold %d bytes\n", (int)stack_size);
+		#endif
+		
+		handle_free(&ProcessTable, p->pid);		//Give the process descriptor back
+		--Task_Count;
 		kernel_raise_error(MALLOC_FAILED_ERR);
 		return 0;
 	}
 	
-	memset(p->stack, 0, stack_size);
+	p->stack_size = stack_size;
+	#ifdef PAINT_STACKS
+	Workspace_Repaint_Stack(p->stack, stack_size);
+	p->stack_peak = 0;
+	#endif
+	
 	p->sp = &p->stack[stack_size-1];
 	Kernel_Init_Task_Stack(&p->sp, f);
 	
+	//The new task can now be considered by the scheduler
+	Kernel_Ready_Task(p);
+	
 	
 	return p->pid;
 }
@@ -80,24 +124,33 @@ PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int
 //For creating a new task dynamically when the kernel is already running
 void Kernel_Create_Task(void)
 {
-	#define req_func_pointer	Current_Process->request_args[0].ptr
-	#define req_stack_size		Current_Process->request_args[1].val
-	#define req_priority		Current_Process->request_args[2].val
-	#define req_taskarg			Current_Process->request_args[3].val
+	#define req_func_pointer	((taskfuncptr)Syscall_Arg(Current_Process, 0))
+	#define req_stack_size		Syscall_Arg_Val(Current_Process, 1)
+	#define req_priority		Syscall_Arg_Val(Current_Process, 2)
+	#define req_taskarg			Syscall_Arg_Val(Current_Process, 3)
+	#define req_quantum			Syscall_Arg_Val(Current_Process, 4)
 	
-	Current_Process->request_retval = Kernel_Create_Task_Direct(req_func_pointer, req_stack_size, req_priority, req_taskarg);
+	Syscall_Return(Current_Process, Kernel_Create_Task_Direct(req_func_pointer, req_stack_size, req_priority, req_taskarg, req_quantum));
 	
 	#undef req_func_pointer
 	#undef req_func_pointer
 	#undef req_priority
 	#undef req_taskarg
+	#undef req_quantum
+}
+
+
+//The yielding task is placed back at the tail of its ready queue when the next task is dispatched
+void Kernel_Yield_Task(void)
+{
+	Kernel_Request_Cswitch = 1;
 }
 
 
 void Kernel_Suspend_Task() 
 {
 	//Finds the process descriptor for the specified PID
-	PD* p = findProcessByPID(Current_Process->request_args[0].val);
+	PD* p = findProcessByPID(Syscall_Arg_Val(Current_Process, 0));
 	
 	//Ensure the PID specified in the PD currently exists in the global process list
 	if(p == NULL)
@@ -125,7 +178,8 @@ void Kernel_Suspend_Task()
 		p->last_state = READY;
 	else
 		p->last_state = p->state;
-		
+	
+	Kernel_Unready_Task(p);
 	p->state = SUSPENDED;
 	
 }
@@ -134,7 +188,7 @@ void Kernel_Suspend_Task()
 void Kernel_Resume_Task()
 {
 	//Finds the process descriptor for the specified PID
-	PD* p = findProcessByPID(Current_Process->request_args[0].val);
+	PD* p = findProcessByPID(Syscall_Arg_Val(Current_Process, 0));
 	
 	//Ensure the PID specified in the PD currently exists in the global process list
 	if(p == NULL)
@@ -158,8 +212,8 @@ void Kernel_Resume_Task()
 	}
 	
 	//Restore the previous state of the task
-	if(p->last_state == RUNNING)
-		p->state = READY;
+	if(p->last_state == RUNNING || p->last_state == READY)
+		Kernel_Ready_Task(p);
 	else
 		p->state = p->last_state;
 		
@@ -171,7 +225,7 @@ void Kernel_Resume_Task()
 
 void Kernel_Sleep_Task(void)
 {
-	//Sleep ticks is already set by the OS call
+	Current_Process->request_timeout = Syscall_Arg_Val(Current_Process, 0);
 	Current_Process->state = SLEEPING;
 	Kernel_Request_Cswitch = 1;
 }
@@ -182,9 +236,199 @@ void Kernel_Terminate_Task(void)
 	Current_Process->state = DEAD;	
 	--Task_Count;
 	
-	//Free the task's stack and its PD
-	free(Current_Process->stack);
-	ptrlist_remove(&ProcessList, ptrlist_find(&ProcessList, Current_Process));		//Free the PD used by the terminated task
+	//Return the task's stack to the workspace, and its PD to the pool. The kernel can still read the PD until another task is created
+	Workspace_Free_Stack(Current_Process->stack);
+	handle_free(&ProcessTable, Current_Process->pid);		//Its PID is never found again, and the slot can be reused
 	
 	Kernel_Request_Cswitch = 1;
-}
\ No newline at end of file
+}
+
+
+#ifdef PREEMPTIVE_CSWITCH
+void Kernel_Set_Task_Quantum(void)
+{
+	#define req_pid				Syscall_Arg_Val(Current_Process, 0)
+	#define req_quantum			Syscall_Arg_Val(Current_Process, 1)
+	
+	PD* p;
+	
+	//PID 0 lets a task change its own quantum without knowing its PID
+	if(req_pid == 0)
+		p = (PD*)Current_Process;
+	else
+		p = findProcessByPID(req_pid);
+	
+	if(p == NULL)
+	{
+		#ifdef DEBUG
+			printf("Kernel_Set_Task_Quantum: PID not found in global process list!\n");
+		#endif
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
+		return;
+	}
+	
+	//The task keeps what's left of its current slice, but never more than the new quantum allows
+	//A task that had no slice (quantum was 0) starts a full one, or the tick would wrap its slice_remaining and never preempt it
+	p->quantum = req_quantum;
+	if(p->slice_remaining == 0 || p->slice_remaining > p->quantum)
+		p->slice_remaining = p->quantum;
+	
+	#undef req_pid
+	#undef req_quantum
+}
+#endif
+
+
+#ifdef PAINT_STACKS
+//Returns the most bytes of stack a task has used so far. The stack grows down, so everything above the lowest byte that has lost its paint was used.
+//Only the bytes below the last peak can still be painted, so measuring a task periodically doesn't rescan the part of the stack it uses
+size_t Kernel_Stack_Peak(PD *p)
+{
+	size_t painted = 0;
+	size_t limit = p->stack_size - p->stack_peak;
+	
+	while(painted < limit && p->stack[painted] == STACK_PAINT_PATTERN)
+		++painted;
+	
+	p->stack_peak = p->stack_size - painted;
+	return p->stack_peak;
+}
+
+void Kernel_Get_Task_Stack_Usage(void)
+{
+	#define req_pid				Syscall_Arg_Val(Current_Process, 0)
+	
+	PD* p;
+	
+	//PID 0 lets a task measure its own stack without knowing its PID
+	if(req_pid == 0)
+		p = (PD*)Current_Process;
+	else
+		p = findProcessByPID(req_pid);
+	
+	if(p == NULL)
+	{
+		#ifdef DEBUG
+			printf("Kernel_Get_Task_Stack_Usage: PID not found in global process list!\n");
+		#endif
+		kernel_raise_error(OBJECT_NOT_FOUND_ERR);
+		Syscall_Return(Current_Process, 0);
+		return;
+	}
+	
+	Syscall_Return(Current_Process, Kernel_Stack_Peak(p));
+	
+	#undef req_pid
+}
+#endif
+
+
+#ifdef EDF_SCHEDULING
+void Kernel_Set_Task_Deadline(void)
+{
+	#define req_ticks			Syscall_Arg_Val(Current_Process, 0)
+	
+	Current_Process->deadline = Kernel_Now() + req_ticks;
+	Current_Process->has_deadline = 1;
+	
+	//Another task in the EDF band may have an earlier deadline now, so let the scheduler decide again
+	if(Current_Process->pri == EDF_PRIORITY)
+		Kernel_Request_Cswitch = 1;
+	
+	#undef req_ticks
+}
+#endif
+
+
+#ifdef PERIODIC_TASKS
+PID Kernel_Create_Periodic_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK period, TICK offset)
+{
+	PID pid;
+	PD *p;
+	
+	if(period == 0)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Create_Periodic_Task: The period must be at least 1 tick\n");
+		#endif
+		
+		kernel_raise_error(INVALID_ARG_ERR);
+		return 0;
+	}
+	
+	pid = Kernel_Create_Task_Direct(f, stack_size, py, arg, PREEMPTIVE_CSWITCH_FREQ);
+	if(!pid)
+		return 0;
+	
+	//Releases are absolute ticks, so the time each job takes doesn't push the later releases back
+	p = findProcessByPID(pid);
+	p->period = period;
+	p->next_release = Kernel_Now() + offset;
+	
+	return pid;
+}
+
+//For creating a new periodic task dynamically when the kernel is already running
+void Kernel_Create_Periodic_Task(void)
+{
+	#define req_func_pointer	((taskfuncptr)Syscall_Arg(Current_Process, 0))
+	#define req_stack_size		Syscall_Arg_Val(Current_Process, 1)
+	#define req_priority		Syscall_Arg_Val(Current_Process, 2)
+	#define req_taskarg			Syscall_Arg_Val(Current_Process, 3)
+	#define req_period			Syscall_Arg_Val(Current_Process, 4)
+	#define req_offset			Syscall_Arg_Val(Current_Process, 5)
+	
+	Syscall_Return(Current_Process, Kernel_Create_Periodic_Task_Direct(req_func_pointer, req_stack_size, req_priority, req_taskarg, req_period, req_offset));
+	
+	#undef req_func_pointer
+	#undef req_stack_size
+	#undef req_priority
+	#undef req_taskarg
+	#undef req_period
+	#undef req_offset
+}
+
+//Records how long a released job waited before it was dispatched
+void Kernel_Start_Periodic_Job(PD *p)
+{
+	TICK jitter = Kernel_Now() - (p->next_release - p->period);
+	
+	if(jitter > p->max_jitter)
+		p->max_jitter = jitter;
+	p->job_released = 0;
+}
+
+void Kernel_Wait_Next_Period(void)
+{
+	TICK now = Kernel_Now();
+	TICK release;
+	
+	if(Current_Process->period == 0)
+	{
+		#ifdef DEBUG
+		printf("Kernel_Wait_Next_Period: PID %d is not a periodic task!\n", Current_Process->pid);
+		#endif
+		kernel_raise_error(UNPROCESSABLE_TASK_STATE_ERR);
+		return;
+	}
+	
+	release = Current_Process->next_release;
+	Current_Process->next_release += Current_Process->period;
+	Current_Process->job_released = 1;
+	
+	//The previous job ran past this release. Start the next job right away, but keep the following releases in phase
+	if((int)(TICK)(release - now) <= 0)
+	{
+		if(release != now)
+			++Current_Process->overruns;
+		
+		Kernel_Start_Periodic_Job((PD*)Current_Process);
+		return;
+	}
+	
+	//Park the task until the release tick. The timeout queue wakes it up like a regular sleep
+	Current_Process->request_timeout = release - now;
+	Current_Process->state = SLEEPING;
+	Kernel_Request_Cswitch = 1;
+}
+#endif
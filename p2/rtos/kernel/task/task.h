@@ -5,20 +5,38 @@
 
 #include "../kernel_shared.h"
 #include "../hardware/cpuarch.h"
+#include "workspace.h"
 
 
 
-PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg);
+PID Kernel_Create_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK quantum);
 void Kernel_Create_Task(void);
+void Kernel_Yield_Task(void);
 void Task_Reset(void);
 void Kernel_Suspend_Task(void);
 void Kernel_Resume_Task(void); 
 void Kernel_Sleep_Task(void);
 void Kernel_Terminate_Task(void);
+#ifdef PREEMPTIVE_CSWITCH
+void Kernel_Set_Task_Quantum(void);
+#endif
+#ifdef PAINT_STACKS
+size_t Kernel_Stack_Peak(PD *p);
+void Kernel_Get_Task_Stack_Usage(void);
+#endif
+#ifdef EDF_SCHEDULING
+void Kernel_Set_Task_Deadline(void);
+#endif
+#ifdef PERIODIC_TASKS
+PID Kernel_Create_Periodic_Task_Direct(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK period, TICK offset);
+void Kernel_Create_Periodic_Task(void);
+void Kernel_Wait_Next_Period(void);
+void Kernel_Start_Periodic_Job(PD *p);
+#endif
 
 
 /*Variables shared with the main kernel module*/
-extern volatile PtrList ProcessList;					//Be responsible when directly accessing Process Descriptors
+extern HandleTable ProcessTable;						//Be responsible when directly accessing Process Descriptors
 extern volatile unsigned int Task_Count;	
 
 
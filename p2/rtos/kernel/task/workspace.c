@@ -0,0 +1,154 @@
+/*
+Task stacks are carved out of the workspace into the classes listed in STACK_CLASSES (see os.h).
+Every class keeps a list of its free stacks, so taking a stack and giving it back take constant time.
+Free stacks are handed out last in first out, so a task that is created right after another one terminates reuses the same stack.
+*/
+
+#include "workspace.h"
+
+
+#define STACK_CLASS_BYTES(size, count)		+ (size) * (count)
+#define STACK_CLASS_INIT(size, count)		{size, count},
+
+#if (0 STACK_CLASSES(STACK_CLASS_BYTES)) > WORKSPACE_HEAP_SIZE
+#error "The stacks in STACK_CLASSES do not fit in WORKSPACE_HEAP_SIZE"
+#endif
+
+static void* Workspace[WORKSPACE_HEAP_SIZE / sizeof(void*)];		//Declared as pointers, so the link in each free stack is aligned
+static STACK_CLASS Stack_Classes[] = { STACK_CLASSES(STACK_CLASS_INIT) };
+
+#define NUM_STACK_CLASSES	(sizeof(Stack_Classes) / sizeof(Stack_Classes[0]))
+
+//Free stacks are linked through their top bytes, which a task always dirties anyway, so the paint at the bottom stays intact
+#define FREE_LINK(stack, size)		(*(void**)((stack) + (size) - sizeof(void*)))
+
+#ifndef STACK_REPAINT_RUN
+#define STACK_REPAINT_RUN	32				//Painted bytes in a row that mark the end of the part of a stack the last task used. 0 repaints whole stacks
+#endif
+
+
+//Carves every class out of the workspace, and puts all of their stacks in the free lists
+void Workspace_Reset(void)
+{
+	unsigned char *next_stack = (unsigned char*)Workspace;
+	STACK_CLASS *c;
+	unsigned int i, j;
+	
+	#ifdef PAINT_STACKS
+	memset(Workspace, STACK_PAINT_PATTERN, sizeof(Workspace));		//Painted once here. Recycled stacks only repaint what was used
+	#endif
+
+	for(i=0; i<NUM_STACK_CLASSES; i++)
+	{
+		c = &Stack_Classes[i];
+		c->in_use = 0;
+		c->peak = 0;
+		c->start = next_stack;
+		c->free_head = NULL;
+
+		//Link the stacks from the last to the first, so they're handed out in address order
+		for(j=c->count; j>0; j--)
+		{
+			FREE_LINK(c->start + (j-1) * c->size, c->size) = c->free_head;
+			c->free_head = c->start + (j-1) * c->size;
+		}
+
+		next_stack += c->size * c->count;
+	}
+}
+
+
+//Takes a free stack from the smallest class that fits stack_size, and updates stack_size to the size of the stack it got. Returns NULL if none are free
+unsigned char* Workspace_Alloc_Stack(size_t *stack_size)
+{
+	STACK_CLASS *c;
+	unsigned char *stack;
+	unsigned int i;
+
+	for(i=0; i<NUM_STACK_CLASSES; i++)
+	{
+		c = &Stack_Classes[i];
+		if(c->size < *stack_size || !c->free_head)
+			continue;
+
+		stack = c->free_head;
+		c->free_head = FREE_LINK(stack, c->size);
+
+		if(++c->in_use > c->peak)
+			c->peak = c->in_use;
+
+		*stack_size = c->size;
+		return stack;
+	}
+
+	return NULL;
+}
+
+
+//Returns a stack to the free list of the class it came from
+void Workspace_Free_Stack(unsigned char *stack)
+{
+	STACK_CLASS *c;
+	unsigned int i;
+
+	for(i=0; i<NUM_STACK_CLASSES; i++)
+	{
+		c = &Stack_Classes[i];
+		if(stack < c->start || stack >= c->start + c->size * c->count)
+			continue;
+
+		FREE_LINK(stack, c->size) = c->free_head;
+		c->free_head = stack;
+		--c->in_use;
+		return;
+	}
+
+	#ifdef DEBUG
+	printf("Workspace_Free_Stack: %p is not a stack from the workspace!\n", stack);
+	#endif
+}
+
+
+#ifdef PAINT_STACKS
+//Repaints a stack that another task used before. The stack grows down, so the used part is at the top, and painting stops
+//once STACK_REPAINT_RUN bytes in a row still hold the paint.
+//This is a heuristic: if the last task left a gap of STACK_REPAINT_RUN or more untouched bytes inside the part it used (eg. a large
+//local array it never filled), the dirty bytes below the gap are not repainted. They are then counted in the next task's peak, which
+//reads high by up to the previous task's peak. It never reads low. Define STACK_REPAINT_RUN as 0 to repaint whole stacks instead
+void Workspace_Repaint_Stack(unsigned char *stack, size_t stack_size)
+{
+	#if STACK_REPAINT_RUN == 0
+	memset(stack, STACK_PAINT_PATTERN, stack_size);
+	#else
+	unsigned char *b = stack + stack_size;
+	unsigned int run = 0;
+	
+	while(b > stack && run < STACK_REPAINT_RUN)
+	{
+		if(*--b == STACK_PAINT_PATTERN)
+			++run;
+		else
+		{
+			*b = STACK_PAINT_PATTERN;
+			run = 0;
+		}
+	}
+	#endif
+}
+#endif
+
+
+void print_workspace(void)
+{
+	unsigned int i;
+
+	for(i=0; i<NUM_STACK_CLASSES; i++)
+		printf("\tStack size: %d\t In use: %d/%d\t Peak: %d\n", (int)Stack_Classes[i].size, Stack_Classes[i].in_use, Stack_Classes[i].count, Stack_Classes[i].peak);
+	printf("\n");
+}
+
+
+#undef STACK_CLASS_BYTES
+#undef STACK_CLASS_INIT
+#undef NUM_STACK_CLASSES
+#undef FREE_LINK
@@ -0,0 +1,31 @@
+/* The WORKSPACE holds the stacks of every task. It is part of the TASK module. */
+
+#ifndef WORKSPACE_H_
+#define WORKSPACE_H_
+
+#include "../kernel_shared.h"
+
+
+/*A class of equally sized stacks in the workspace. Free stacks are linked through their top bytes*/
+typedef struct {
+
+	size_t size;								//Size of each stack in bytes
+	unsigned char count;						//Number of stacks in the class
+	unsigned char in_use;
+	unsigned char peak;							//Most stacks ever in use at the same time
+	unsigned char *start;						//First stack of the class. The rest follow it
+	void *free_head;							//First free stack, or NULL if all of them are in use
+
+} STACK_CLASS;
+
+
+void Workspace_Reset(void);
+unsigned char* Workspace_Alloc_Stack(size_t *stack_size);
+void Workspace_Free_Stack(unsigned char *stack);
+#ifdef PAINT_STACKS
+void Workspace_Repaint_Stack(unsigned char *stack, size_t stack_size);
+#endif
+void print_workspace(void);
+
+
+#endif /* WORKSPACE_H_ */
@@ -21,14 +21,39 @@ void OS_Start(void)
 	Kernel_Start();
 }
 
+TICK OS_Get_Ticks(void)
+{
+	TICK now;
+	
+	//The tick count is updated by the timer ISR, so read it atomically
+	Disable_Interrupt();
+	now = Kernel_Now();
+	Enable_Interrupt();
+	
+	return now;
+}
+
+#ifdef CSWITCH_PROFILE
+unsigned int OS_Get_Cswitch_Cycles(void)
+{
+	unsigned int cycles;
+	
+	Disable_Interrupt();
+	cycles = Kernel_Get_Cswitch_Cycles();
+	Enable_Interrupt();
+	
+	return cycles;
+}
+#endif
+
 
 /************************************************************************/
 /*						Task/Thread related API                         */
 /************************************************************************/
 
 
-/* OS call to create a new task */
-PID Task_Create(taskfuncptr f, size_t stack_size, PRIORITY py, int arg)
+/* Creates a new task with its own time slice (in ticks). Task_Create() uses PREEMPTIVE_CSWITCH_FREQ */
+PID Task_Create_Quantum(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK quantum)
 {
    PID retval;
    
@@ -36,18 +61,10 @@ PID Task_Create(taskfuncptr f, size_t stack_size, PRIORITY py, int arg)
    if (KernelActive) 
    {
      Disable_Interrupt();
-	 Current_Process->request_args[0].ptr = f;
-	 Current_Process->request_args[1].val = stack_size;
-	 Current_Process->request_args[2].val = py;
-	 Current_Process->request_args[3].val = arg;
-	 Current_Process->request = TASK_CREATE;
-     Enter_Kernel();									//Interrupts are automatically reenabled once the kernel is exited
-	 
-	 //Retrieve the return value once the kernel exits
-	 retval = Current_Process->request_retval;
+     retval = Kernel_Syscall5(TASK_CREATE, (uintptr_t)f, stack_size, py, arg, quantum);		//Interrupts are automatically reenabled once the kernel is exited
    } 
    else 
-	  retval = Kernel_Create_Task_Direct(f,stack_size,py,arg);				//If kernel hasn't started yet, manually create the task
+	  retval = Kernel_Create_Task_Direct(f,stack_size,py,arg,quantum);				//If kernel hasn't started yet, manually create the task
    
    //Return zero as PID if the task creation process gave errors. Note that the smallest valid PID is 1
    if (err == MAX_OBJECT_ERR)
@@ -60,6 +77,12 @@ PID Task_Create(taskfuncptr f, size_t stack_size, PRIORITY py, int arg)
    return retval;
 }
 
+/* OS call to create a new task */
+PID Task_Create(taskfuncptr f, size_t stack_size, PRIORITY py, int arg)
+{
+	return Task_Create_Quantum(f, stack_size, py, arg, PREEMPTIVE_CSWITCH_FREQ);
+}
+
 /* The calling task terminates itself. */
 void Task_Terminate()
 {
@@ -69,8 +92,7 @@ void Task_Terminate()
 	}
 
 	Disable_Interrupt();
-	Current_Process -> request = TASK_TERMINATE;
-	Enter_Kernel();			
+	Kernel_Syscall0(TASK_TERMINATE);
 }
 
 /* The calling task gives up its share of the processor voluntarily. Previously Task_Next() */
@@ -82,8 +104,7 @@ void Task_Yield()
 	}
 
     Disable_Interrupt();
-    Current_Process->request = TASK_YIELD;
-    Enter_Kernel();
+    Kernel_Syscall0(TASK_YIELD);
 }
 
 int Task_GetArg()
@@ -103,9 +124,7 @@ void Task_Suspend(PID p)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = TASK_SUSPEND;
-	Current_Process->request_args[0].val = p;
-	Enter_Kernel();
+	Kernel_Syscall1(TASK_SUSPEND, p);
 }
 
 void Task_Resume(PID p)
@@ -116,10 +135,104 @@ void Task_Resume(PID p)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = TASK_RESUME;
-	Current_Process->request_args[0].val = p;
-	Enter_Kernel();
+	Kernel_Syscall1(TASK_RESUME, p);
+}
+
+#ifdef PREEMPTIVE_CSWITCH
+/*Changes how many ticks a task may run before it is preempted. Takes effect on its current slice*/
+void Task_Set_Quantum(PID p, TICK quantum)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return;
+	}
+	
+	Disable_Interrupt();
+	Kernel_Syscall2(TASK_SET_QUANTUM, p, quantum);
+}
+#endif
+
+#ifdef PAINT_STACKS
+size_t Task_Stack_Usage(PID p)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall1(TASK_STACK_USAGE, p);
+}
+#endif
+
+#ifdef EDF_SCHEDULING
+/*Sets the calling task's next deadline to t ticks from now. Only affects tasks created at EDF_PRIORITY*/
+void Task_Set_Deadline(TICK t)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return;
+	}
+	
+	Disable_Interrupt();
+	Kernel_Syscall1(TASK_SET_DEADLINE, t);
+}
+#endif
+
+#ifdef PERIODIC_TASKS
+/*Creates a task that is released every period ticks, starting offset ticks from now. The task should call Task_Wait_Next_Period() at the start of each job*/
+PID Task_Create_Periodic(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK period, TICK offset)
+{
+	PID retval;
+	
+	if (KernelActive)
+	{
+		Disable_Interrupt();
+		retval = Kernel_Syscall6(TASK_CREATE_PERIODIC, (uintptr_t)f, stack_size, py, arg, period, offset);
+	}
+	else
+		retval = Kernel_Create_Periodic_Task_Direct(f, stack_size, py, arg, period, offset);
+	
+	if (!retval)
+		return 0;
+	
+	#ifdef DEBUG
+	printf("Created periodic PID: %d\n", retval);
+	#endif
+	
+	return retval;
+}
+
+/*Blocks the calling periodic task until its next job is released. Returns immediately if the release has already passed*/
+void Task_Wait_Next_Period()
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return;
+	}
+	
+	Disable_Interrupt();
+	Kernel_Syscall0(TASK_WAIT_PERIOD);
+}
+
+/*Longest delay (in ticks) between a release and the calling task starting that job*/
+TICK Task_Get_Max_Jitter()
+{
+	if (KernelActive)
+		return Current_Process->max_jitter;
+	else
+		return 0;
+}
+
+/*Number of jobs that were released late, because the calling task's previous job was still running*/
+unsigned int Task_Get_Overruns()
+{
+	if (KernelActive)
+		return Current_Process->overruns;
+	else
+		return 0;
 }
+#endif
 
 /*Puts the calling task to sleep for AT LEAST t ticks.*/
 void Task_Sleep(TICK t)
@@ -130,9 +243,7 @@ void Task_Sleep(TICK t)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = TASK_SLEEP;
-	Current_Process->request_timeout = t;
-	Enter_Kernel();
+	Kernel_Syscall1(TASK_SLEEP, t);
 }
 
 
@@ -148,20 +259,17 @@ EVENT Event_Create(void)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = E_CREATE;
-		Enter_Kernel();
-		
-		retval = Current_Process->request_retval;
+		retval = Kernel_Syscall0(E_CREATE);
 	}
 	else
-		retval = Kernel_Create_Event();		//Call the kernel function directly if kernel has not started yet.	
+		retval = Kernel_Create_Event_Direct();		//Call the kernel function directly if kernel has not started yet.	
 	
 	//Return zero as Event ID if the event creation process gave errors. Note that the smallest valid event ID is 1
 	if (err == MAX_OBJECT_ERR)
 		return 0;
 	
 	#ifdef DEBUG
-	printf("Created Event: %d\n", Last_EventID);
+	printf("Created Event: %d\n", retval);
 	#endif
 	
 	return retval;
@@ -175,9 +283,7 @@ void Event_Wait(EVENT e)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = E_WAIT;
-	Current_Process->request_args[0].val = e;
-	Enter_Kernel();
+	Kernel_Syscall1(E_WAIT, e);
 	
 }
 
@@ -189,9 +295,7 @@ void Event_Signal(EVENT e)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = E_SIGNAL;
-	Current_Process->request_args[0].val = e;
-	Enter_Kernel();	
+	Kernel_Syscall1(E_SIGNAL, e);
 }
 
 #endif
@@ -209,20 +313,17 @@ MUTEX Mutex_Create(void)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = MUT_CREATE;
-		Enter_Kernel();
-		
-		retval = Current_Process->request_retval;
+		retval = Kernel_Syscall0(MUT_CREATE);
 	}
 	else
-		retval = Kernel_Create_Mutex();	//Call the kernel function directly if OS hasn't start yet
+		retval = Kernel_Create_Mutex_Direct();	//Call the kernel function directly if OS hasn't start yet
 		
 	//Return zero as Mutex ID if the mutex creation process gave errors. Note that the smallest valid mutex ID is 1
 	if (err == MAX_OBJECT_ERR)
 	return 0;
 	
 	#ifdef DEBUG
-	printf("Created Mutex: %d\n", Last_MutexID);
+	printf("Created Mutex: %d\n", retval);
 	#endif
 	
 	return retval;
@@ -233,9 +334,7 @@ int Mutex_Destroy(MUTEX m)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = MUT_DESTROY;
-		Current_Process->request_args[0].val = m;
-		Enter_Kernel();
+		Kernel_Syscall1(MUT_DESTROY, m);
 	}
 	
 	return (err > 0)? 0:1;	//return 1 if no error, return 0 if semaphore was not found
@@ -249,9 +348,7 @@ void Mutex_Lock(MUTEX m)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = MUT_LOCK;
-	Current_Process->request_args[0].val = m;
-	Enter_Kernel();
+	Kernel_Syscall1(MUT_LOCK, m);
 }
 
 void Mutex_Unlock(MUTEX m)
@@ -262,9 +359,7 @@ void Mutex_Unlock(MUTEX m)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = MUT_UNLOCK;
-	Current_Process->request_args[0].val = m;
-	Enter_Kernel();
+	Kernel_Syscall1(MUT_UNLOCK, m);
 }
 #endif
 
@@ -280,12 +375,7 @@ SEMAPHORE Semaphore_Create(int initial_count, unsigned int is_binary)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = SEM_CREATE;
-		Current_Process->request_args[0].val = initial_count;
-		Current_Process->request_args[1].val = is_binary;
-		Enter_Kernel();
-		
-		retval = Current_Process->request_retval;
+		retval = Kernel_Syscall2(SEM_CREATE, initial_count, is_binary);
 	}
 	else
 		retval = Kernel_Create_Semaphore_Direct(initial_count, is_binary);		//Call the kernel function directly if OS hasn't start yet
@@ -295,7 +385,7 @@ SEMAPHORE Semaphore_Create(int initial_count, unsigned int is_binary)
 		return 0;
 	
 	#ifdef DEBUG
-	printf("Created Semaphore: %d\n", Last_SemaphoreID);
+	printf("Created Semaphore: %d\n", retval);
 	#endif
 	
 	return retval;
@@ -306,9 +396,7 @@ int Semaphore_Destroy(SEMAPHORE s)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = SEM_DESTROY;
-		Current_Process->request_args[0].val = s;
-		Enter_Kernel();
+		Kernel_Syscall1(SEM_DESTROY, s);
 	}
 	
 	return (err > 0)? 0:1;	//return 1 if no error, return 0 if semaphore was not found
@@ -322,10 +410,7 @@ void Semaphore_Give(SEMAPHORE s, unsigned int amount)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = SEM_GIVE;
-	Current_Process->request_args[0].val = s;
-	Current_Process->request_args[1].val = amount;
-	Enter_Kernel();
+	Kernel_Syscall2(SEM_GIVE, s, amount);
 }
 
 void Semaphore_Get(SEMAPHORE s, unsigned int amount)
@@ -336,10 +421,7 @@ void Semaphore_Get(SEMAPHORE s, unsigned int amount)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = SEM_GET;
-	Current_Process->request_args[0].val = s;
-	Current_Process->request_args[1].val = amount;
-	Enter_Kernel();
+	Kernel_Syscall2(SEM_GET, s, amount);
 }
 
 #endif
@@ -356,13 +438,10 @@ EVENT_GROUP Event_Group_Create(void)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = EG_CREATE;
-		Enter_Kernel();
-		
-		retval = Current_Process->request_retval;
+		retval = Kernel_Syscall0(EG_CREATE);
 	}
 	else
-		retval = Kernel_Create_Event_Group();	//Call the kernel function directly if kernel has not started yet.
+		retval = Kernel_Create_Event_Group_Direct();	//Call the kernel function directly if kernel has not started yet.
 	
 	
 	//Return zero as Event ID if the event creation process gave errors. Note that the smallest valid event ID is 1
@@ -370,7 +449,7 @@ EVENT_GROUP Event_Group_Create(void)
 	return 0;
 	
 	#ifdef DEBUG
-	printf("Created Event Group: %d\n", Last_Event_Group_ID);
+	printf("Created Event Group: %d\n", retval);
 	#endif
 	
 	return retval;
@@ -381,9 +460,7 @@ int Event_Group_Destroy(EVENT_GROUP eg)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = EG_DESTROY;
-		Current_Process->request_args[0].val = eg;
-		Enter_Kernel();
+		Kernel_Syscall1(EG_DESTROY, eg);
 	}
 	
 	return (err > 0)? 0:1;	//return 1 if no error, return 0 if semaphore was not found
@@ -397,10 +474,7 @@ void Event_Group_Set_Bits(EVENT_GROUP e, unsigned int bits_to_set)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = EG_SETBITS;
-	Current_Process->request_args[0].val = e;
-	Current_Process->request_args[1].val = bits_to_set;
-	Enter_Kernel();
+	Kernel_Syscall2(EG_SETBITS, e, bits_to_set);
 }
 
 void Event_Group_Clear_Bits(EVENT_GROUP e, unsigned int bits_to_clear)
@@ -411,10 +485,7 @@ void Event_Group_Clear_Bits(EVENT_GROUP e, unsigned int bits_to_clear)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = EG_CLEARBITS;
-	Current_Process->request_args[0].val = e;
-	Current_Process->request_args[1].val = bits_to_clear;
-	Enter_Kernel();
+	Kernel_Syscall2(EG_CLEARBITS, e, bits_to_clear);
 }
 
 void Event_Group_Wait_Bits(EVENT_GROUP e, unsigned int bits_to_wait, unsigned int wait_all_bits, TICK timeout)
@@ -425,12 +496,7 @@ void Event_Group_Wait_Bits(EVENT_GROUP e, unsigned int bits_to_wait, unsigned in
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = EG_WAITBITS;
-	Current_Process->request_args[0].val = e;
-	Current_Process->request_args[1].val = bits_to_wait;
-	Current_Process->request_args[2].val = wait_all_bits;
-	Current_Process->request_timeout = timeout;
-	Enter_Kernel();
+	Kernel_Syscall4(EG_WAITBITS, e, bits_to_wait, wait_all_bits, timeout);
 }
 
 
@@ -442,10 +508,7 @@ unsigned int Event_Group_Get_Bits(EVENT_GROUP e)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = EG_GETBITS;
-	Enter_Kernel();
-	
-	return Current_Process->request_retval;
+	return Kernel_Syscall1(EG_GETBITS, e);
 }
 
 #endif
@@ -463,20 +526,39 @@ MAILBOX Mailbox_Create(unsigned int capacity)
 	if(KernelActive)
 	{
 		Disable_Interrupt();
-		Current_Process->request = MB_CREATE;
-		Current_Process->request_args[0].val = capacity;
-		Enter_Kernel();
-		
-		retval = Current_Process->request_retval;
+		retval = Kernel_Syscall2(MB_CREATE, capacity, 0);
 	}
 	else
-		retval = Kernel_Create_Mailbox_Direct(capacity);		//Call the kernel function directly if OS hasn't start yet
+		retval = Kernel_Create_Mailbox_Direct(capacity, 0);		//Call the kernel function directly if OS hasn't start yet
 	
 	if(err != NO_ERR)
 		return 0;
 	
 	#ifdef DEBUG
-	printf("Created Mailbox: %d\n", Last_MailboxID);
+	printf("Created Mailbox: %d\n", retval);
+	#endif
+	
+	return retval;
+}
+
+
+MAILBOX Mailbox_Create_Ring(unsigned int capacity, size_t slot_size)
+{
+	MAILBOX retval;
+	
+	if(KernelActive)
+	{
+		Disable_Interrupt();
+		retval = Kernel_Syscall2(MB_CREATE, capacity, slot_size);
+	}
+	else
+		retval = Kernel_Create_Mailbox_Direct(capacity, slot_size);
+	
+	if(err != NO_ERR)
+		return 0;
+	
+	#ifdef DEBUG
+	printf("Created Ring Mailbox: %d\n", retval);
 	#endif
 	
 	return retval;
@@ -491,9 +573,7 @@ void Mailbox_Destroy(MAILBOX mb)
 	}
 		
 	Disable_Interrupt();
-	Current_Process->request = MB_DESTROY;
-	Current_Process->request_args[0].val = mb;
-	Enter_Kernel();
+	Kernel_Syscall1(MB_DESTROY, mb);
 }
 
 
@@ -505,11 +585,7 @@ int Mailbox_Destroy_Mail(MAIL* received)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = MB_DESTROYM;
-	Current_Process->request_args[0].ptr = received;
-	Enter_Kernel();
-	
-	return Current_Process->request_retval;
+	return Kernel_Syscall1(MB_DESTROYM, (uintptr_t)received);
 }
 
 
@@ -521,38 +597,77 @@ int Mailbox_Check(MAILBOX mb)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request = MB_CHECKMAIL;
-	Current_Process->request_args[0].val = mb;
-	Enter_Kernel();
+	return Kernel_Syscall1(MB_CHECKMAIL, mb);
+}
+
+
+int Mailbox_Send(MAILBOX mb, void *msg, size_t msg_size)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_SENDMAIL, mb, (uintptr_t)msg, msg_size, 0, 0);
+}
+
+int Mailbox_Recv(MAILBOX mb, MAIL* received)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
 	
-	return Current_Process->request_retval;
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_RECVMAIL, mb, (uintptr_t)received, 0, 0, 0);
 }
 
+int Mailbox_Send_Blocking(MAILBOX mb, void *msg, size_t msg_size, TICK timeout)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_SENDMAIL, mb, (uintptr_t)msg, msg_size, 1, timeout);
+}
+
+int Mailbox_Recv_Blocking(MAILBOX mb, MAIL* received, TICK timeout)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_RECVMAIL, mb, (uintptr_t)received, 1, timeout, 0);
+}
 
-static inline int Mailbox_Send_Helper(MAILBOX mb, void *msg, size_t msg_size, int blocking)
+int Mailbox_Recv_Copy(MAILBOX mb, MAIL* received, void *buf)
 {
-	Current_Process->request = MB_SENDMAIL;
-	Current_Process->request_args[0].val = mb;
-	Current_Process->request_args[1].ptr = msg;
-	Current_Process->request_args[2].val = msg_size;
-	Current_Process->request_args[3].val = blocking;
-	Enter_Kernel();
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
 	
-	return Current_Process->request_retval;
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_RECVMAIL, mb, (uintptr_t)received, 0, 0, (uintptr_t)buf);
 }
 
-static inline int Mailbox_Recv_Helper(MAILBOX mb, MAIL* received, int blocking)
+int Mailbox_Recv_Copy_Blocking(MAILBOX mb, MAIL* received, void *buf, TICK timeout)
 {
-	Current_Process->request = MB_RECVMAIL;
-	Current_Process->request_args[0].val = mb;
-	Current_Process->request_args[1].ptr = received;
-	Current_Process->request_args[2].val = blocking;
-	Enter_Kernel();
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
 	
-	return Current_Process->request_retval;
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_RECVMAIL, mb, (uintptr_t)received, 1, timeout, (uintptr_t)buf);
 }
 
-int Mailbox_Send(MAILBOX mb, void *msg, size_t msg_size)
+int Mailbox_Send_Many(MAILBOX mb, void *msgs, size_t msg_size, unsigned int count, unsigned int min_count, TICK timeout)
 {
 	if(!KernelActive){
 		kernel_raise_error(KERNEL_INACTIVE_ERR);
@@ -560,10 +675,10 @@ int Mailbox_Send(MAILBOX mb, void *msg, size_t msg_size)
 	}
 	
 	Disable_Interrupt();
-	return Mailbox_Send_Helper(mb, msg, msg_size, 0);
+	return Kernel_Syscall6(MB_SENDMANY, mb, (uintptr_t)msgs, msg_size, min_count, timeout, count);
 }
 
-int Mailbox_Recv(MAILBOX mb, MAIL* received)
+int Mailbox_Recv_Many(MAILBOX mb, MAIL* received, void *bufs, unsigned int count, unsigned int min_count, TICK timeout)
 {
 	if(!KernelActive){
 		kernel_raise_error(KERNEL_INACTIVE_ERR);
@@ -571,10 +686,24 @@ int Mailbox_Recv(MAILBOX mb, MAIL* received)
 	}
 	
 	Disable_Interrupt();
-	return Mailbox_Recv_Helper(mb, received, 0);
+	return Kernel_Syscall6(MB_RECVMANY, mb, (uintptr_t)received, min_count, timeout, (uintptr_t)bufs, count);
 }
 
-int Mailbox_Send_Blocking(MAILBOX mb, void *msg, size_t msg_size, TICK timeout)
+void* Mailbox_Alloc_Buffer(size_t size)
+{
+	void *buf = NULL;
+	
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return NULL;
+	}
+	
+	Disable_Interrupt();
+	Kernel_Syscall2(MB_ALLOCBUF, size, (uintptr_t)&buf);		//Returned through buf, since a pointer may not fit the return value
+	return buf;
+}
+
+int Mailbox_Free_Buffer(void *buf)
 {
 	if(!KernelActive){
 		kernel_raise_error(KERNEL_INACTIVE_ERR);
@@ -582,11 +711,63 @@ int Mailbox_Send_Blocking(MAILBOX mb, void *msg, size_t msg_size, TICK timeout)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request_timeout = timeout;
-	return Mailbox_Send_Helper(mb, msg, msg_size, 1);
+	return Kernel_Syscall1(MB_FREEBUF, (uintptr_t)buf);
 }
 
-int Mailbox_Recv_Blocking(MAILBOX mb, MAIL* received, TICK timeout)
+int Mailbox_Send_Buffer(MAILBOX mb, void *buf, size_t msg_size)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_SENDBUF, mb, (uintptr_t)buf, msg_size, 0, 0);
+}
+
+int Mailbox_Send_Buffer_Blocking(MAILBOX mb, void *buf, size_t msg_size, TICK timeout)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	Disable_Interrupt();
+	return Kernel_Syscall5(MB_SENDBUF, mb, (uintptr_t)buf, msg_size, 1, timeout);
+}
+
+
+
+#endif
+
+/************************************************************************/
+/*						ISR Queue related API			                */
+/************************************************************************/
+#ifdef ISR_QUEUE_ENABLED
+
+ISR_QUEUE ISR_Queue_Create(unsigned int capacity, size_t item_size)
+{
+	ISR_QUEUE retval;
+	
+	if(KernelActive)
+	{
+		Disable_Interrupt();
+		retval = Kernel_Syscall2(ISRQ_CREATE, capacity, item_size);
+	}
+	else
+		retval = Kernel_Create_ISR_Queue_Direct(capacity, item_size);		//Call the kernel function directly if OS hasn't start yet
+	
+	if(err != NO_ERR)
+		return 0;
+	
+	#ifdef DEBUG
+	printf("Created ISR Queue: %d\n", retval);
+	#endif
+	
+	return retval;
+}
+
+int ISR_Queue_Destroy(ISR_QUEUE q)
 {
 	if(!KernelActive){
 		kernel_raise_error(KERNEL_INACTIVE_ERR);
@@ -594,10 +775,37 @@ int Mailbox_Recv_Blocking(MAILBOX mb, MAIL* received, TICK timeout)
 	}
 	
 	Disable_Interrupt();
-	Current_Process->request_timeout = timeout;
-	return Mailbox_Recv_Helper(mb, received, 1);
+	Kernel_Syscall1(ISRQ_DESTROY, q);
+	
+	return (err > 0)? 0:1;
 }
 
+//Both ends work on the queue directly. Only a consumer that has to wait enters the kernel
+int ISR_Queue_Push(ISR_QUEUE q, const void *item)
+{
+	return Kernel_ISR_Queue_Push(q, item);
+}
 
+int ISR_Queue_Pop(ISR_QUEUE q, void *item)
+{
+	return Kernel_ISR_Queue_Pop(q, item);
+}
+
+int ISR_Queue_Pop_Blocking(ISR_QUEUE q, void *item, TICK timeout)
+{
+	if(!KernelActive){
+		kernel_raise_error(KERNEL_INACTIVE_ERR);
+		return 0;
+	}
+	
+	while(!Kernel_ISR_Queue_Pop(q, item))
+	{
+		Disable_Interrupt();
+		if(!Kernel_Syscall2(ISRQ_WAIT, q, timeout))
+			return 0;
+	}
+	
+	return 1;
+}
 
 #endif
\ No newline at end of file
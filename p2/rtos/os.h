@@ -18,25 +18,45 @@
 #define LOWEST_PRIORITY				10				//0 is the highest priority, 10 the lowest
 #define WORKSPACE_HEAP_SIZE			4096			//The total amount of workspace memory dedicated across ALL tasks
 #define KERNEL_HEAP_SIZE			1024			//Heap size (in bytes) allocated for the kernel for allocating kernel objects
+#define PAINT_STACKS								//Fill every new task stack with STACK_PAINT_PATTERN. Otherwise stacks are handed out as they were left
+#define STACK_PAINT_PATTERN			0xA5
+
+/*
+ * Stack size classes carved out of the workspace, smallest first. Each X(size, count) entry is count stacks of size bytes.
+ * A task gets a stack from the smallest class that fits and has one free. Sizes must be multiples of the pointer size
+ */
+#define STACK_CLASSES(X)			\
+	X(128, 8)						\
+	X(256, 10)
 
 
 /*Scheduler configuration*/
 #define PREEMPTIVE_CSWITCH							//Enable preemptive multi-tasking
-#define PREEMPTIVE_CSWITCH_FREQ		25				//How frequently (in ticks) does preemptive scheduling kick in?
+#define PREEMPTIVE_CSWITCH_FREQ		25				//Default time slice (in ticks) a task may run before it is preempted. See Task_Create_Quantum()
 #define PREVENT_STARVATION							//Enable starvation prevention in the scheduler
 #define STARVATION_MAX				MAXTHREAD*10	//Maximum amount of ticks missed before a task is considered starving
+//#define EDF_SCHEDULING							//Schedule tasks at EDF_PRIORITY by earliest deadline first, instead of round robin
+#define EDF_PRIORITY				5				//Priority level used as the EDF band. Tasks above and below it are still fixed priority
+#define PERIODIC_TASKS								//Enable periodic tasks, released by the kernel at fixed ticks
+//#define MAILBOX_HAND_OFF						//Pass a mail straight to a receiver that is already waiting for it, instead of queueing it in the mailbox first
+#define PRIORITY_WAIT_QUEUES						//Wake the highest priority task blocked on a mutex, semaphore, event group or mailbox first, instead of the one that blocked first
 
 
 /*Timer*/
 #define MSECPERTICK					10				//resolution of a system tick (in milliseconds).
 
 
+/*Profiling*/
+//#define CSWITCH_PROFILE							//Measure the cost of a context switch. See OS_Get_Cswitch_Cycles()
+
+
 /*Choose which optional kernel modules to enable*/
 #define EVENT_ENABLED
 #define MUTEX_ENABLED
 #define EVENT_GROUP_ENABLED
 #define SEMAPHORE_ENABLED
 #define MAILBOX_ENABLED
+#define ISR_QUEUE_ENABLED
 
 
 
@@ -50,6 +70,7 @@ typedef unsigned char PRIORITY;
 typedef unsigned int EVENT;
 typedef unsigned int EVENT_GROUP;
 typedef unsigned int MAILBOX;
+typedef unsigned int ISR_QUEUE;
 typedef unsigned int TICK;
 
 typedef void (*taskfuncptr) (void);      /* pointer to void f(void), used to represent the main function for a RTOS task */
@@ -72,11 +93,17 @@ typedef unsigned int TICK;
 void OS_Init(void);
 void OS_Start(void);
 void OS_Abort(void);
+TICK OS_Get_Ticks(void);													//Number of ticks since the OS started
+
+#ifdef CSWITCH_PROFILE
+unsigned int OS_Get_Cswitch_Cycles(void);									//Cheapest kernel entry and exit seen so far, in CPU cycles
+#endif
 
 
 
 /*Task/Thread related functions*/
 PID Task_Create(taskfuncptr f, size_t stack_size, PRIORITY py, int arg);
+PID Task_Create_Quantum(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK quantum);	//A quantum of 0 disables time slicing for that task
 void Task_Terminate(void);
 void Task_Sleep(TICK t);													// sleep time is at least t*MSECPERTICK
 void Task_Suspend(PID p);													//Suspend/Resume tasks by the function name instead
@@ -84,6 +111,25 @@ void Task_Resume(PID p);
 void Task_Yield(void);
 int  Task_GetArg(void);
 
+#ifdef PREEMPTIVE_CSWITCH
+void Task_Set_Quantum(PID p, TICK quantum);								//PID 0 refers to the calling task
+#endif
+
+#ifdef PAINT_STACKS
+size_t Task_Stack_Usage(PID p);											//Most bytes of stack the task has used so far. PID 0 refers to the calling task
+#endif
+
+#ifdef EDF_SCHEDULING
+void Task_Set_Deadline(TICK t);												//Calling task's next deadline is t ticks from now
+#endif
+
+#ifdef PERIODIC_TASKS
+PID Task_Create_Periodic(taskfuncptr f, size_t stack_size, PRIORITY py, int arg, TICK period, TICK offset);	//First job is released offset ticks from now
+void Task_Wait_Next_Period(void);											//Ends the current job, and waits for the next release
+TICK Task_Get_Max_Jitter(void);
+unsigned int Task_Get_Overruns(void);
+#endif
+
 
 
 
@@ -120,6 +166,7 @@ int Event_Group_Destroy(EVENT_GROUP eg);
 void Event_Group_Set_Bits(EVENT_GROUP e, unsigned int bits_to_set);
 void Event_Group_Clear_Bits(EVENT_GROUP e, unsigned int bits_to_clear);
 void Event_Group_Wait_Bits(EVENT_GROUP e, unsigned int bits_to_wait, unsigned int wait_all_bits, TICK timeout);
+unsigned int Event_Group_Get_Bits(EVENT_GROUP e);
 #endif
 
 
@@ -127,6 +174,7 @@ void Event_Group_Wait_Bits(EVENT_GROUP e, unsigned int bits_to_wait, unsigned in
 #ifdef MAILBOX_ENABLED
 typedef struct MAIL MAIL;													//Formally declared in mailbox/mailbox.h
 MAILBOX Mailbox_Create(unsigned int capacity);
+MAILBOX Mailbox_Create_Ring(unsigned int capacity, size_t slot_size);		//Preallocates capacity slots of slot_size bytes. Sends copy into a slot, and never allocate
 void Mailbox_Destroy(MAILBOX mb);
 int Mailbox_Destroy_Mail(MAIL* m);
 int Mailbox_Check(MAILBOX mb);
@@ -134,7 +182,25 @@ int Mailbox_Send(MAILBOX mb, void* msg, size_t msg_size);
 int Mailbox_Recv(MAILBOX mb, MAIL* received);
 int Mailbox_Send_Blocking(MAILBOX mb, void *msg, size_t msg_size, TICK timeout);
 int Mailbox_Recv_Blocking(MAILBOX mb, MAIL* received, TICK TIMEOUT);
+int Mailbox_Recv_Copy(MAILBOX mb, MAIL* received, void *buf);				//Receives from a ring mailbox by copying into buf, which must hold slot_size bytes
+int Mailbox_Recv_Copy_Blocking(MAILBOX mb, MAIL* received, void *buf, TICK timeout);
+int Mailbox_Send_Many(MAILBOX mb, void *msgs, size_t msg_size, unsigned int count, unsigned int min_count, TICK timeout);	//Sends count messages of msg_size bytes each, stored one after another. Waits until at least min_count are sent, or the kernel heap runs out, and returns how many were
+int Mailbox_Recv_Many(MAILBOX mb, MAIL* received, void *bufs, unsigned int count, unsigned int min_count, TICK timeout);	//Receives up to count mails into received[]. A ring mailbox copies them into bufs, count slots one after another. NULL otherwise
+void* Mailbox_Alloc_Buffer(size_t size);									//A buffer to fill in place and send without a copy. NULL if the kernel heap is full
+int Mailbox_Free_Buffer(void *buf);											//Frees a buffer that was never sent. Received ones are freed with Mailbox_Destroy_Mail()
+int Mailbox_Send_Buffer(MAILBOX mb, void *buf, size_t msg_size);			//Hands buf itself to the receiver. The sender must not touch it again once it's sent
+int Mailbox_Send_Buffer_Blocking(MAILBOX mb, void *buf, size_t msg_size, TICK timeout);
 #endif 
 
 
+/*ISR QUEUE. Carries items from one ISR to one task*/
+#ifdef ISR_QUEUE_ENABLED
+ISR_QUEUE ISR_Queue_Create(unsigned int capacity, size_t item_size);		//The capacity must be a power of two, up to 128
+int ISR_Queue_Destroy(ISR_QUEUE q);
+int ISR_Queue_Push(ISR_QUEUE q, const void *item);						//Only for the producing ISR. Never enters the kernel. Returns 0 if the queue is full
+int ISR_Queue_Pop(ISR_QUEUE q, void *item);								//Never enters the kernel. Returns 0 if the queue is empty
+int ISR_Queue_Pop_Blocking(ISR_QUEUE q, void *item, TICK timeout);		//Waits for an item if the queue is empty. Returns 0 if it timed out
+#endif
+
+
 #endif /* _OS_H_ */
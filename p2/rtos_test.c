@@ -3,8 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef __AVR__
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#else
+unsigned char PORTB, DDRB;				//The host port has no onboard LED
+#endif
 
 #define LED_PIN_MASK 0x80			//Pin 13 = PB7
 
@@ -17,13 +21,16 @@ void Idle()
 };
 
 
-#define TEST_SET_8
+//Select which test set to run. Can also be given on the command line, eg. -DTEST_SET=4
+#ifndef TEST_SET
+#define TEST_SET 8
+#endif
 
 
 /************************************************************************/
 /*					TEST_SET_0 is an empty template						*/
 /************************************************************************/
-#ifdef TEST_SET_0
+#if TEST_SET == 0
 
 void t1()
 {
@@ -49,7 +56,7 @@ void test()
 /************************************************************************/
 /*				Test 1: Task Suspension, Resume, Sleep, Yield		    */
 /************************************************************************/
-#ifdef TEST_SET_1
+#if TEST_SET == 1
 
 PID Ping_PID, Pong_PID;
 
@@ -129,7 +136,7 @@ void test()
 /*						Test 2: Priority			                    */
 /************************************************************************/
 
-#ifdef TEST_SET_2
+#if TEST_SET == 2
 
 void priority1()
 {
@@ -175,7 +182,7 @@ void test()
 /*					Test 3: Starvation Prevention		                */
 /************************************************************************/
 
-#ifdef TEST_SET_3
+#if TEST_SET == 3
 
 void ps1()
 {
@@ -239,7 +246,7 @@ void test()
 /*					Test 4: Preemptive Scheduling		                */
 /************************************************************************/
 
-#ifdef TEST_SET_4
+#if TEST_SET == 4
 
 void ps1()
 {
@@ -292,7 +299,7 @@ void test()
 /*							Test 5: Semaphores	                        */
 /************************************************************************/
 
-#ifdef TEST_SET_5
+#if TEST_SET == 5
 
 SEMAPHORE s1;
 
@@ -338,7 +345,7 @@ void test()
 /*							Test 6: Events			                    */
 /************************************************************************/
 
-#ifdef TEST_SET_6
+#if TEST_SET == 6
 
 EVENT e1;
 
@@ -385,7 +392,7 @@ void test()
 /*						Test 7: Event Groups				            */
 /************************************************************************/
 
-#ifdef TEST_SET_7
+#if TEST_SET == 7
 
 EVENT_GROUP eg1;
 
@@ -460,7 +467,7 @@ void test()
 
 //Note: This test requires preemptive scheduling to be enabled
 
-#ifdef TEST_SET_8
+#if TEST_SET == 8
 
 MUTEX m1;
 
@@ -519,7 +526,7 @@ void test()
  * p  lock creates(q)                         (gain priority)unlock                                           terminate
  */
 
-#ifdef TEST_SET_9
+#if TEST_SET == 9
 
 MUTEX mut;
 
@@ -567,7 +574,7 @@ void test()
 /************************************************************************/
 /*				Test 10: Basic Mailbox Send/Recv (async)	            */
 /************************************************************************/
-#ifdef TEST_SET_10
+#if TEST_SET == 10
 
 typedef struct {
 	int a;
@@ -641,7 +648,7 @@ void test()
 /************************************************************************/
 /*				Test 11: Basic Mailbox Send/Recv (async)	            */
 /************************************************************************/
-#ifdef TEST_SET_11
+#if TEST_SET == 11
 
 typedef struct {
 	int a;
@@ -716,7 +723,7 @@ void test()
 /************************************************************************/
 /*					Test 12: Mailbox Blocking Send						*/
 /************************************************************************/
-#ifdef TEST_SET_12
+#if TEST_SET == 12
 
 typedef struct {
 	int a;
@@ -817,7 +824,7 @@ void test()
 /************************************************************************/
 /*					Test 13: Mailbox Blocking Recv						*/
 /************************************************************************/
-#ifdef TEST_SET_13
+#if TEST_SET == 13
 
 typedef struct {
 	int a;
@@ -931,6 +938,937 @@ void test()
 
 
 
+/************************************************************************/
+/*					Test 14: Dispatch Latency Benchmark					*/
+/************************************************************************/
+
+//Measures the average cost of a Task_Yield() round trip through the scheduler, as more sleeping tasks are added.
+//The dispatch cost should stay flat from 4 tasks up to MAXTHREAD tasks.
+
+#if TEST_SET == 14
+
+#define YIELDS_PER_SAMPLE		100
+#define SLEEPER_STACK_SIZE		128
+
+void sleeper()
+{
+	for(;;)
+		Task_Sleep(60000);
+}
+
+void dispatch_bench()
+{
+	unsigned int i, start;
+	unsigned long total;
+	
+	#ifndef CSWITCH_PROFILE
+	Perf_Counter_init();			//Otherwise the kernel has started it already
+	#endif
+	
+	for(;;)
+	{
+		total = 0;
+		for(i=0; i<YIELDS_PER_SAMPLE; i++)
+		{
+			start = Perf_Counter_Read();
+			Task_Yield();
+			total += (unsigned int)(Perf_Counter_Read() - start);
+		}
+		printf("Tasks: %d\t Avg cycles per yield: %lu\n", Task_Count, total/YIELDS_PER_SAMPLE);
+		
+		#ifdef CSWITCH_PROFILE
+		printf("Cheapest kernel entry and exit: %u cycles\n", OS_Get_Cswitch_Cycles());
+		#endif
+		
+		if(Task_Count >= MAXTHREAD)
+			break;
+		
+		Task_Create(sleeper, SLEEPER_STACK_SIZE, 5, 0);
+	}
+	
+	printf("Dispatch benchmark finished!\n");
+	Task_Terminate();
+}
+
+void test()
+{
+	//Start with 4 tasks: The benchmark task itself and 3 sleeping tasks
+	Task_Create(dispatch_bench, TASK_STACK_SIZE, 0, 0);
+	Task_Create(sleeper, SLEEPER_STACK_SIZE, 5, 0);
+	Task_Create(sleeper, SLEEPER_STACK_SIZE, 5, 0);
+	Task_Create(sleeper, SLEEPER_STACK_SIZE, 5, 0);
+}
+
+#endif
+
+
+
+
+/************************************************************************/
+/*						Test 15: Per-Task Time Slices					*/
+/************************************************************************/
+
+//Two busy tasks share the same priority, with quanta of 2 and 20 ticks. The long slice task should get about 10 times the CPU,
+//so the first report should show a long/short ratio close to 10.0. After it, the long slice task is cut down to 2 ticks as well,
+//and every later report should show a ratio close to 1.0.
+//The workers never stop counting, so each report is the difference between two snapshots taken by the monitor.
+
+#if TEST_SET == 15
+
+volatile unsigned long short_count, long_count;
+PID long_pid;
+
+void short_slice()
+{
+	for(;;)
+		++short_count;
+}
+
+void long_slice()
+{
+	for(;;)
+		++long_count;
+}
+
+void monitor()
+{
+	unsigned long short_last, long_last, short_now, long_now, short_share, long_share;
+	
+	short_last = short_count;
+	long_last = long_count;
+	
+	for(;;)
+	{
+		Task_Sleep(200);
+		
+		//The monitor outranks both workers, so neither counter moves while it is running
+		short_now = short_count;
+		long_now = long_count;
+		short_share = short_now - short_last;
+		long_share = long_now - long_last;
+		short_last = short_now;
+		long_last = long_now;
+		
+		//Ratio printed with one decimal place, since printf on the AVR has no floating point
+		if(short_share == 0)
+			short_share = 1;
+		printf("Short slice: %lu\t Long slice: %lu\t Long/Short: %lu.%lu\n", short_share, long_share,
+				long_share / short_share, (long_share * 10 / short_share) % 10);
+		
+		Task_Set_Quantum(long_pid, 2);
+	}
+}
+
+void test()
+{
+	Task_Create_Quantum(short_slice, TASK_STACK_SIZE, 5, 0, 2);
+	long_pid = Task_Create_Quantum(long_slice, TASK_STACK_SIZE, 5, 0, 20);
+	Task_Create(monitor, TASK_STACK_SIZE, 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*					Test 16: Earliest Deadline First					*/
+/************************************************************************/
+
+//Three tasks in the EDF band are created in the opposite order of their deadlines, but should always run in deadline order.
+//The fixed priority tasks above and below the band should still preempt it, and run only when it's idle, respectively.
+
+#if TEST_SET == 16
+
+#ifndef EDF_SCHEDULING
+#error "Test 16 needs EDF_SCHEDULING defined in os.h"
+#endif
+
+void edf_task()
+{
+	int relative_deadline = Task_GetArg();
+	
+	for(;;)
+	{
+		Task_Set_Deadline(relative_deadline);
+		printf("EDF: Deadline in %d ticks\n", relative_deadline);
+		Task_Sleep(100);
+	}
+}
+
+void above_edf()
+{
+	for(;;)
+	{
+		printf("Priority %d: Above the EDF band\n", EDF_PRIORITY - 1);
+		Task_Sleep(100);
+	}
+}
+
+void below_edf()
+{
+	for(;;)
+	{
+		printf("Priority %d: Below the EDF band\n", EDF_PRIORITY + 1);
+		Task_Sleep(100);
+	}
+}
+
+void test()
+{
+	Task_Create(below_edf, TASK_STACK_SIZE, EDF_PRIORITY + 1, 0);
+	Task_Create(edf_task, TASK_STACK_SIZE, EDF_PRIORITY, 30);
+	Task_Create(edf_task, TASK_STACK_SIZE, EDF_PRIORITY, 20);
+	Task_Create(edf_task, TASK_STACK_SIZE, EDF_PRIORITY, 10);
+	Task_Create(above_edf, TASK_STACK_SIZE, EDF_PRIORITY - 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 17: Periodic Tasks							*/
+/************************************************************************/
+
+//A periodic task and a Task_Sleep() loop both do 3 ticks of work every 20 ticks. The periodic task's releases should stay
+//at multiples of 20 ticks, while the sleeping task drifts by the work it does in each loop.
+//Every 5th job of the periodic task takes 25 ticks instead, which should be counted as an overrun without shifting its later releases.
+
+#if TEST_SET == 17
+
+#define PERIOD			20
+#define WORK_TICKS		3
+
+void busy_for(TICK t)
+{
+	TICK start = OS_Get_Ticks();
+	
+	while((TICK)(OS_Get_Ticks() - start) < t);
+}
+
+void periodic()
+{
+	int job;
+	
+	for(job = 1;; job++)
+	{
+		Task_Wait_Next_Period();
+		printf("Periodic: Job %d at tick %u. Max jitter: %u, Overruns: %u\n", job, OS_Get_Ticks(), Task_Get_Max_Jitter(), Task_Get_Overruns());
+		busy_for(job % 5 == 0? PERIOD + 5 : WORK_TICKS);
+	}
+}
+
+void sleeper()
+{
+	int job;
+	
+	for(job = 1;; job++)
+	{
+		Task_Sleep(PERIOD);
+		printf("Sleeper: Job %d at tick %u\n", job, OS_Get_Ticks());
+		busy_for(WORK_TICKS);
+	}
+}
+
+void test()
+{
+	Task_Create_Periodic(periodic, TASK_STACK_SIZE, 2, 0, PERIOD, PERIOD);
+	Task_Create(sleeper, TASK_STACK_SIZE, 3, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 18: Stale Object IDs						*/
+/************************************************************************/
+
+//A mutex is destroyed and a new one takes over its slot in the mutex table. The new mutex should get a different ID,
+//and destroying the old ID again should fail instead of destroying the new mutex.
+
+#if TEST_SET == 18
+
+void t()
+{
+	MUTEX old_mut, new_mut;
+	
+	old_mut = Mutex_Create();
+	printf("Destroying mutex %d: %d\n", old_mut, Mutex_Destroy(old_mut));
+	
+	new_mut = Mutex_Create();
+	printf("Destroying stale mutex %d: %d\n", old_mut, Mutex_Destroy(old_mut));
+	printf("Destroying mutex %d: %d\n", new_mut, Mutex_Destroy(new_mut));
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	Task_Create(t, TASK_STACK_SIZE, 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*					Test 19: Timeouts in Wait Queues					*/
+/************************************************************************/
+
+//A receiver times out on an empty mailbox. It must leave the mailbox's wait queue when it does, so the next mail
+//stays in the mailbox instead of being handed to a task that is no longer waiting for it.
+
+#if TEST_SET == 19
+
+void t()
+{
+	MAILBOX mb = Mailbox_Create(1);
+	char msg[] = "Hello";
+	MAIL m;
+	int retval;
+	
+	retval = Mailbox_Recv_Blocking(mb, &m, 5);
+	printf("Blocking receive timed out: %d\n", retval);
+	
+	retval = Mailbox_Send(mb, msg, sizeof(msg));
+	printf("Sent: %d, Mails waiting: %d\n", retval, Mailbox_Check(mb));
+	
+	retval = Mailbox_Recv(mb, &m);
+	printf("Received: %d, Message: %s\n", retval, (char*)m.ptr);
+	Mailbox_Destroy_Mail(&m);
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	Task_Create(t, TASK_STACK_SIZE, 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 20: Stack Classes							*/
+/************************************************************************/
+
+//Stacks come from the smallest class that fits and has one free. Once the small class runs out, small tasks spill into
+//the next class, and a stack larger than every class can't be created. Terminated tasks give their stacks back.
+
+#if TEST_SET == 20
+
+void worker()
+{
+	Task_Sleep(10);
+}
+
+void t()
+{
+	int i;
+	
+	for(i=0; i<9; i++)
+		Task_Create(worker, 100, 5, 0);
+	Task_Create(worker, 200, 5, 0);
+	print_workspace();
+	
+	printf("Creating a task with a 1024 byte stack: PID %d\n", Task_Create(worker, 1024, 5, 0));
+	
+	Task_Sleep(20);
+	printf("All workers have terminated\n");
+	print_workspace();
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	Task_Create(t, TASK_STACK_SIZE, 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 21: Stack Usage							*/
+/************************************************************************/
+
+//Each task recurses to a different depth, then reports the most stack it has used. A deeper task should report more.
+//The host port runs tasks on their own host stacks, so there only the kernel's writes to the stacks are counted.
+
+#if TEST_SET == 21
+
+int recurse(int depth)
+{
+	volatile char frame[8];
+	
+	frame[0] = depth;
+	if(depth == 0)
+		return frame[0];
+	return recurse(depth - 1) + frame[0];
+}
+
+void t()
+{
+	recurse(Task_GetArg());
+	printf("Recursed %d deep, and used %d bytes of stack\n", Task_GetArg(), (int)Task_Stack_Usage(0));
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void report()
+{
+	Task_Sleep(10);
+	print_processes();
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	Task_Create(t, TASK_STACK_SIZE, 1, 1);
+	Task_Create(t, TASK_STACK_SIZE, 1, 4);
+	Task_Create(t, TASK_STACK_SIZE, 1, 8);
+	Task_Create(report, TASK_STACK_SIZE, 2, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*					Test 22: Task Respawn Benchmark						*/
+/************************************************************************/
+
+//A worker-per-request pattern: the spawner creates a higher priority worker and yields to it, and the worker terminates right away.
+//Reports the average time of a whole create, run and terminate cycle, in Perf_Counter_Read() counts.
+//Build it with STACK_REPAINT_RUN set to 0 (see workspace.c) to compare against repainting each recycled stack in full.
+
+#if TEST_SET == 22
+
+#define RESPAWNS_PER_SAMPLE		1000
+#define RESPAWN_SAMPLES			5
+
+void worker()
+{
+}
+
+void spawner()
+{
+	unsigned int i, j, start;
+	unsigned long total;
+	
+	#ifndef CSWITCH_PROFILE
+	Perf_Counter_init();			//Otherwise the kernel has started it already
+	#endif
+	
+	for(j=0; j<RESPAWN_SAMPLES; j++)
+	{
+		total = 0;
+		for(i=0; i<RESPAWNS_PER_SAMPLE; i++)
+		{
+			start = Perf_Counter_Read();
+			Task_Create(worker, TASK_STACK_SIZE, 0, 0);
+			Task_Yield();					//Lets the worker run and terminate
+			total += (unsigned int)(Perf_Counter_Read() - start);
+		}
+		printf("Avg counts per create and terminate: %lu\n", total/RESPAWNS_PER_SAMPLE);
+	}
+	
+	printf("Respawn benchmark finished!\n");
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	Task_Create(spawner, TASK_STACK_SIZE, 1, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*					Test 23: Priority Ordered Wait Queues				*/
+/************************************************************************/
+
+//Waiters block on a semaphore from the lowest priority to the highest, with two of them sharing a priority. Each give wakes
+//one waiter. With PRIORITY_WAIT_QUEUES they wake highest priority first, and the two equal ones in the order they blocked.
+
+#if TEST_SET == 23
+
+SEMAPHORE s;
+PRIORITY waiter_pri[] = {4, 3, 2, 2, 1};
+
+void waiter()
+{
+	int n = Task_GetArg();
+	
+	Task_Sleep(n + 1);						//Block in the order of the waiters
+	printf("Waiter %d with priority %d is waiting\n", n, waiter_pri[n]);
+	Semaphore_Get(s, 1);
+	printf("Waiter %d woke up\n", n);
+}
+
+void giver()
+{
+	int i;
+	
+	Task_Sleep(10);
+	for(i=0; i<5; i++)
+	{
+		Semaphore_Give(s, 1);
+		Task_Sleep(2);						//Let the woken waiter print before waking the next one
+	}
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	int i;
+	
+	s = Semaphore_Create(0, 0);
+	Task_Create(giver, TASK_STACK_SIZE, 0, 0);
+	for(i=0; i<5; i++)
+		Task_Create(waiter, TASK_STACK_SIZE, waiter_pri[i], i);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 24: Zero-Copy Mailbox						*/
+/************************************************************************/
+
+//A producer fills a buffer in place and hands it to a mailbox. A relay forwards the same buffer to a second mailbox,
+//and the consumer destroys it. Once a task has passed a buffer on, it can no longer send or free it.
+
+#if TEST_SET == 24
+
+MAILBOX mb1, mb2;
+
+void producer()
+{
+	char *frame = Mailbox_Alloc_Buffer(16);
+	
+	strcpy(frame, "Sensor frame");
+	printf("Producer sends buffer %p: %d\n", frame, Mailbox_Send_Buffer(mb1, frame, strlen(frame)+1));
+	printf("Producer frees the buffer it sent: %d\n", Mailbox_Free_Buffer(frame));
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void relay()
+{
+	MAIL m;
+	
+	Mailbox_Recv_Blocking(mb1, &m, 0);
+	printf("Relay received buffer %p: %s\n", m.ptr, (char*)m.ptr);
+	printf("Relay forwards it: %d\n", Mailbox_Send_Buffer(mb2, m.ptr, m.size));
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void consumer()
+{
+	MAIL m;
+	
+	Mailbox_Recv_Blocking(mb2, &m, 0);
+	printf("Consumer received buffer %p from PID %d: %s\n", m.ptr, m.source, (char*)m.ptr);
+	printf("Consumer destroys it: %d\n", Mailbox_Destroy_Mail(&m));
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	mb1 = Mailbox_Create(1);
+	mb2 = Mailbox_Create(1);
+	
+	Task_Create(consumer, TASK_STACK_SIZE, 1, 0);
+	Task_Create(relay, TASK_STACK_SIZE, 2, 0);
+	Task_Create(producer, TASK_STACK_SIZE, 3, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 25: Ring Mailboxes							*/
+/************************************************************************/
+
+//A ring mailbox with 3 slots of 8 bytes. The producer sends more mails than there are slots, so it blocks until the
+//consumer frees one, and the slots wrap around. Messages larger than a slot are refused.
+
+#if TEST_SET == 25
+
+MAILBOX mb;
+
+void producer()
+{
+	char msg[] = "Mail 0";
+	int i, retval;
+	
+	retval = Mailbox_Send(mb, "Far too long for a slot", 24);
+	printf("Sending 24 bytes: %d\n", retval);
+	
+	for(i=0; i<5; i++)
+	{
+		msg[5] = '0' + i;
+		retval = Mailbox_Send_Blocking(mb, msg, sizeof(msg), 0);
+		printf("Sent %s: %d\n", msg, retval);
+	}
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void consumer()
+{
+	char buf[8];
+	MAIL m;
+	int i, retval;
+	
+	Task_Sleep(5);							//Let the mailbox fill up first
+	for(i=0; i<5; i++)
+	{
+		retval = Mailbox_Recv_Copy_Blocking(mb, &m, buf, 0);
+		printf("Received %s from PID %d: %d\n", (char*)m.ptr, m.source, retval);
+	}
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	mb = Mailbox_Create_Ring(3, 8);
+	
+	Task_Create(consumer, TASK_STACK_SIZE, 1, 0);
+	Task_Create(producer, TASK_STACK_SIZE, 2, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*					Test 26: Mailbox Ping-Pong Benchmark				*/
+/************************************************************************/
+
+//Ping sends a mail and waits for Pong's reply, so every receive finds the other task already blocked on the mailbox.
+//Reports the average time of a round trip, in Perf_Counter_Read() counts, for copied mails and for zero-copy buffers.
+//Define MAILBOX_HAND_OFF in os.h to measure the same round trips with mails handed straight to the waiting receiver.
+
+#if TEST_SET == 26
+
+#define ROUND_TRIPS		1000
+
+MAILBOX ping_mb, pong_mb;
+volatile int zero_copy;
+
+void pong()
+{
+	MAIL m;
+	
+	for(;;)
+	{
+		Mailbox_Recv_Blocking(ping_mb, &m, 0);
+		if(zero_copy)
+			Mailbox_Send_Buffer(pong_mb, m.ptr, m.size);			//Send the same buffer back
+		else
+		{
+			Mailbox_Send(pong_mb, m.ptr, m.size);
+			Mailbox_Destroy_Mail(&m);
+		}
+	}
+}
+
+void ping()
+{
+	int msg = 0;
+	unsigned int i, start;
+	unsigned long total = 0;
+	void *buf;
+	MAIL m;
+	
+	#ifndef CSWITCH_PROFILE
+	Perf_Counter_init();					//Otherwise the kernel has started it already
+	#endif
+	
+	Task_Sleep(1);							//Let Pong block first
+	for(i=0; i<ROUND_TRIPS; i++)
+	{
+		start = Perf_Counter_Read();
+		Mailbox_Send(ping_mb, &msg, sizeof(msg));
+		Mailbox_Recv_Blocking(pong_mb, &m, 0);
+		total += (unsigned int)(Perf_Counter_Read() - start);
+		Mailbox_Destroy_Mail(&m);
+	}
+	printf("Avg counts per copied round trip: %lu\n", total/ROUND_TRIPS);
+	
+	zero_copy = 1;
+	buf = Mailbox_Alloc_Buffer(sizeof(msg));
+	total = 0;
+	for(i=0; i<ROUND_TRIPS; i++)
+	{
+		start = Perf_Counter_Read();
+		Mailbox_Send_Buffer(ping_mb, buf, sizeof(msg));
+		Mailbox_Recv_Blocking(pong_mb, &m, 0);
+		total += (unsigned int)(Perf_Counter_Read() - start);
+		buf = m.ptr;
+	}
+	printf("Avg counts per zero-copy round trip: %lu\n", total/ROUND_TRIPS);
+	
+	printf("Ping-pong benchmark finished!\n");
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	ping_mb = Mailbox_Create(1);
+	pong_mb = Mailbox_Create(1);
+	
+	Task_Create(pong, TASK_STACK_SIZE, 1, 0);
+	Task_Create(ping, TASK_STACK_SIZE, 2, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 27: Batched Mailbox Calls					*/
+/************************************************************************/
+
+//A producer sends 10 records in one call to a mailbox with 4 slots, and waits until all of them are sent. The consumer takes
+//up to 3 at a time. Then the cost of moving 16 records is timed, one call per record and one call for all of them.
+
+#if TEST_SET == 27
+
+#define RECORDS			16
+#define BATCH_ROUNDS	100
+
+MAILBOX mb;
+
+void consumer()
+{
+	MAIL m[3];
+	int i, n, total = 0;
+	
+	Task_Sleep(2);							//Let the producer fill the mailbox and block
+	while(total < 10)
+	{
+		n = Mailbox_Recv_Many(mb, m, NULL, 3, 1, 0);
+		printf("Received %d records:", n);
+		for(i=0; i<n; i++)
+		{
+			printf(" %d", *(int*)m[i].ptr);
+			Mailbox_Destroy_Mail(&m[i]);
+		}
+		printf("\n");
+		total += n;
+	}
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void producer()
+{
+	int records[RECORDS];
+	MAIL m[RECORDS];
+	unsigned int i, j, start;
+	unsigned long single = 0, batched = 0;
+	
+	for(i=0; i<RECORDS; i++)
+		records[i] = i;
+	
+	printf("Sent %d records\n", Mailbox_Send_Many(mb, records, sizeof(int), 10, 10, 0));
+	Task_Sleep(10);
+	
+	#ifndef CSWITCH_PROFILE
+	Perf_Counter_init();					//Otherwise the kernel has started it already
+	#endif
+	
+	//The consumer has finished, so this task has the mailboxes to itself
+	mb = Mailbox_Create(RECORDS);
+	for(j=0; j<BATCH_ROUNDS; j++)
+	{
+		start = Perf_Counter_Read();
+		for(i=0; i<RECORDS; i++)
+			Mailbox_Send(mb, &records[i], sizeof(int));
+		for(i=0; i<RECORDS; i++)
+			Mailbox_Recv(mb, &m[i]);
+		single += (unsigned int)(Perf_Counter_Read() - start);
+		
+		for(i=0; i<RECORDS; i++)
+			Mailbox_Destroy_Mail(&m[i]);
+		
+		start = Perf_Counter_Read();
+		Mailbox_Send_Many(mb, records, sizeof(int), RECORDS, 0, 0);
+		Mailbox_Recv_Many(mb, m, NULL, RECORDS, 0, 0);
+		batched += (unsigned int)(Perf_Counter_Read() - start);
+		
+		for(i=0; i<RECORDS; i++)
+			Mailbox_Destroy_Mail(&m[i]);
+	}
+	
+	printf("Avg counts to send and receive %d records one at a time: %lu\n", RECORDS, single/BATCH_ROUNDS);
+	printf("Avg counts to send and receive %d records in one batch: %lu\n", RECORDS, batched/BATCH_ROUNDS);
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	mb = Mailbox_Create(4);
+	
+	Task_Create(consumer, TASK_STACK_SIZE, 1, 0);
+	Task_Create(producer, TASK_STACK_SIZE, 2, 0);
+}
+
+#endif
+
+
+
+
+
+/************************************************************************/
+/*						Test 28: ISR to Task Queue						*/
+/************************************************************************/
+
+//A device pushes ADC samples through its "ISR" without entering the kernel, while it busy waits between samples. The higher
+//priority consumer blocks on the queue, and should get each sample within a tick of it being pushed. Then the consumer times out
+//on an idle queue, and finally a burst of 10 samples overflows the queue of 8
+
+#if TEST_SET == 28
+
+#define SAMPLES			5
+
+typedef struct {
+	unsigned int value;
+	TICK stamp;
+} SAMPLE;
+
+ISR_QUEUE adc;
+volatile unsigned int dropped;
+
+//Stands in for the ADC conversion complete interrupt, which runs with interrupts disabled
+void adc_isr(unsigned int value)
+{
+	SAMPLE s;
+	
+	Disable_Interrupt();
+	s.value = value;
+	s.stamp = Kernel_Now();
+	if(!ISR_Queue_Push(adc, &s))
+		++dropped;
+	Enable_Interrupt();
+}
+
+void busy_wait(TICK t)
+{
+	TICK until = OS_Get_Ticks() + t;
+	while(OS_Get_Ticks() < until);
+}
+
+void device()
+{
+	unsigned int i;
+	
+	for(i=0; i<SAMPLES; i++)
+	{
+		busy_wait(3);
+		adc_isr(i);
+	}
+	
+	busy_wait(10);
+	for(i=0; i<10; i++)
+		adc_isr(100+i);
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void consumer()
+{
+	SAMPLE s;
+	unsigned int i, n = 0;
+	
+	for(i=0; i<SAMPLES; i++)
+	{
+		ISR_Queue_Pop_Blocking(adc, &s, 0);
+		printf("Sample %d pushed at tick %d, received %d ticks later\n", s.value, s.stamp, OS_Get_Ticks() - s.stamp);
+	}
+	
+	if(!ISR_Queue_Pop_Blocking(adc, &s, 5))
+		printf("Timed out waiting on an idle queue\n");
+	
+	ISR_Queue_Pop_Blocking(adc, &s, 0);
+	do
+		printf("Burst sample %d\n", s.value), ++n;
+	while(ISR_Queue_Pop(adc, &s));
+	printf("Received %d burst samples, %d dropped\n", n, dropped);
+	
+	for(;;)
+		Task_Sleep(100);
+}
+
+void test()
+{
+	adc = ISR_Queue_Create(8, sizeof(SAMPLE));
+	
+	Task_Create(consumer, TASK_STACK_SIZE, 1, 0);
+	Task_Create(device, TASK_STACK_SIZE, 2, 0);
+}
+
+#endif
+
+
+
+
 
 /************************************************************************/
 /*						Entry point for application		                */